@@ -0,0 +1,23 @@
+#version 460
+
+layout(location = 0) in vec3 normal;
+layout(location = 1) in vec4 tangent;
+layout(location = 2) in vec2 uv;
+
+layout(location = 0) out vec4 fragColor;
+
+// Front faces are CCW under Vulkan's y-down mapping, so the visible hemisphere faces -z
+const vec3 LIGHT_DIRECTION = normalize(vec3(-0.4, -0.6, 0.7));
+
+void main() {
+    // Perturb the normal with a procedural bump pattern so every attribute is used
+    vec3 n = normalize(normal);
+    vec3 t = normalize(tangent.xyz);
+    vec3 b = cross(n, t) * tangent.w;
+    vec2 bump = 0.15 * vec2(sin(uv.x * 96.0), sin(uv.y * 48.0));
+    vec3 shadingNormal = normalize(n + bump.x * t + bump.y * b);
+
+    float diffuse = max(dot(shadingNormal, -LIGHT_DIRECTION), 0.0);
+    vec3 albedo = mix(vec3(0.25, 0.45, 0.8), vec3(0.9, 0.9, 0.95), step(0.5, fract(uv.x * 8.0)));
+    fragColor = vec4(albedo * (0.1 + 0.9 * diffuse), 1.0);
+}
@@ -0,0 +1,30 @@
+// Matches MeshPushConstants in src/mesh_renderer.hpp
+layout(push_constant) uniform MeshParams {
+    vec3 boundsMin;
+    uint gridSize;
+    vec3 boundsExtent;
+} mesh;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out vec4 outTangent;
+layout(location = 2) out vec2 outUV;
+
+vec3 DecodeOctahedral(vec2 encoded) {
+    vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-direction.z, 0.0);
+    direction.x += direction.x >= 0.0 ? -fold : fold;
+    direction.y += direction.y >= 0.0 ? -fold : fold;
+    return normalize(direction);
+}
+
+// Lays instances out on a grid covering the screen
+void WriteVertex(vec3 position, vec3 normal, vec4 tangent, vec2 uv) {
+    float cellSize = 2.0 / float(mesh.gridSize);
+    uvec2 cell = uvec2(gl_InstanceIndex % mesh.gridSize, gl_InstanceIndex / mesh.gridSize);
+    vec2 center = -1.0 + cellSize * (vec2(cell) + 0.5);
+
+    gl_Position = vec4(center + position.xy * cellSize * 0.45, 0.5 + position.z * 0.25, 1.0);
+    outNormal = normal;
+    outTangent = tangent;
+    outUV = uv;
+}
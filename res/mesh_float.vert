@@ -0,0 +1,19 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "mesh_common.glsl"
+
+// Matches Vertex in src/vertex_encoding.hpp, 12 floats per vertex
+layout(set = 0, binding = 0, std430) readonly buffer Vertices {
+    float values[];
+};
+
+void main() {
+    uint base = gl_VertexIndex * 12;
+    vec3 position = vec3(values[base], values[base + 1], values[base + 2]);
+    vec3 normal = vec3(values[base + 3], values[base + 4], values[base + 5]);
+    vec4 tangent = vec4(values[base + 6], values[base + 7], values[base + 8], values[base + 9]);
+    vec2 uv = vec2(values[base + 10], values[base + 11]);
+
+    WriteVertex(position, normal, tangent, uv);
+}
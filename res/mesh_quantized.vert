@@ -0,0 +1,23 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "mesh_common.glsl"
+
+// Matches QuantizedVertex in src/vertex_encoding.hpp, 5 words per vertex
+layout(set = 0, binding = 0, std430) readonly buffer Vertices {
+    uint words[];
+};
+
+void main() {
+    uint base = gl_VertexIndex * 5;
+    uint positionXY = words[base];
+    uint positionZ = words[base + 1];
+
+    vec3 quantized = vec3(positionXY & 0xFFFFu, positionXY >> 16, positionZ & 0xFFFFu) / 65535.0;
+    vec3 position = mesh.boundsMin + quantized * mesh.boundsExtent;
+    vec3 normal = DecodeOctahedral(unpackSnorm2x16(words[base + 2]));
+    vec4 tangent = vec4(DecodeOctahedral(unpackSnorm2x16(words[base + 3])), (positionZ & 0x10000u) != 0u ? -1.0 : 1.0);
+    vec2 uv = unpackHalf2x16(words[base + 4]);
+
+    WriteVertex(position, normal, tangent, uv);
+}
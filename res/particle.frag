@@ -0,0 +1,9 @@
+#version 460
+
+layout(location = 0) in vec4 color;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    fragColor = color;
+}
@@ -0,0 +1,19 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#include "particle_common.glsl"
+
+layout(set = 0, binding = 0, std430) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(location = 0) out vec4 color;
+
+void main() {
+    Particle particle = particles[gl_VertexIndex];
+    float life = particle.positionAge.w / particle.velocityLifetime.w;
+
+    gl_Position = vec4(particle.positionAge.xy, 0.0, 1.0);
+    gl_PointSize = 1.0;
+    color = vec4(mix(vec3(1.0, 0.8, 0.3), vec3(0.8, 0.2, 0.1), life), 0.25 * (1.0 - life));
+}
@@ -0,0 +1,45 @@
+// Matches Particle in src/particle_system.hpp
+struct Particle {
+    vec4 positionAge;       // xyz position, w age in seconds
+    vec4 velocityLifetime;  // xyz velocity, w lifetime in seconds
+};
+
+// Matches ParticleCounters in src/particle_system.hpp
+struct ParticleCounters {
+    uint aliveCount;
+    uint dispatchX;
+    uint dispatchY;
+    uint dispatchZ;
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+#ifdef PARTICLE_SIMULATION
+#define WORKGROUP_SIZE 256
+
+layout(set = 0, binding = 0, std430) readonly buffer SourceParticles {
+    Particle particles[];
+} source;
+
+layout(set = 0, binding = 1, std430) writeonly buffer DestinationParticles {
+    Particle particles[];
+} destination;
+
+layout(set = 0, binding = 2, std430) readonly buffer SourceCounters {
+    ParticleCounters counters;
+} sourceCounters;
+
+layout(set = 0, binding = 3, std430) buffer DestinationCounters {
+    ParticleCounters counters;
+} destinationCounters;
+
+// Matches ParticlePushConstants in src/particle_system.hpp
+layout(push_constant) uniform SimulationParams {
+    float deltaTime;
+    uint emitCount;
+    uint seed;
+    uint capacity;
+} params;
+#endif
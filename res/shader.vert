@@ -6,10 +6,18 @@ vec2 positions[3] = vec2[](
     vec2(-0.5, 0.5)
 );
 
+layout(push_constant) uniform PushConstants {
+    vec2 offset;
+    float angle;
+} scene;
+
 layout(location = 0) out vec3 color;
 
 void main() {
-    vec3 pos = vec3(positions[gl_VertexIndex], 0.0);
+    vec2 position = positions[gl_VertexIndex];
+    float s = sin(scene.angle);
+    float c = cos(scene.angle);
+    vec3 pos = vec3(mat2(c, s, -s, c) * position + scene.offset, 0.0);
     gl_Position = vec4(pos, 1.0);
-    color = (pos + 1.0) / 2.0;
+    color = (vec3(position, 0.0) + 1.0) / 2.0;
 }
@@ -12,33 +12,37 @@ constexpr auto HAS_COMPUTE_QUEUE = [](std::pair<int, std::vector<IndexTypes>> pa
     return std::ranges::contains(pair.second, IndexTypes::ComputeIndex);
 };
 
-int main() {
-    App app;
+int main(int argc, char **argv) {
+    App app(Settings::FromArgs(argc, argv));
     app.Run();
     return 0;
 }
 
-App::App()
-    : m_WindowResized(false)
+App::App(const Settings &settings)
+    : m_Settings(settings), m_PresentWaitSupported(false), m_WindowResized(false), m_SwapchainDirty(false),
+      m_PresentModeSteps(0), m_ImageCountSteps(0), m_TogglePacing(false), m_ToggleVertexFormat(false)
 {
     InitGLFW();
     InitVulkan();
     CreateDevice();
     CreateSurface();
     CreateSwapchain();
-    CreateShaders("res/vert.spv", "res/frag.spv");
+    CreateShaders("res/shader.vert.spv", "res/shader.frag.spv");
     CreatePipeline();
     SetupDraw();
+    CreateParticles();
+    CreateMeshes();
 }
 
 App::~App() 
 {
     m_Device.destroyFence(m_ExecutionFence);
     m_Device.destroyCommandPool(m_CommandPool);
-    for (const auto &semaphore : m_AcquireFrameSemaphores)
-        m_Device.destroySemaphore(semaphore);
-    for (const auto &semaphore : m_ReleaseFrameSemaphores)
-        m_Device.destroySemaphore(semaphore);
+    DestroyFrameSemaphores();
+    if (m_Settings.particleCount > 0)
+        m_ParticleSystem.Destroy();
+    if (m_Settings.meshGridSize > 0)
+        m_MeshRenderer.Destroy();
     DestroyPipeline();
     m_Device.destroyShaderModule(m_VertexShader);
     m_Device.destroyShaderModule(m_FragmentShader);
@@ -55,18 +59,85 @@ App::~App()
 
 void App::Run()
 {
+    m_InputBuffer.Publish(m_Input);
+
+    std::jthread simulationThread([this](std::stop_token stopToken) { m_Simulation.Run(stopToken, m_InputBuffer); });
+    std::jthread renderThread([this](std::stop_token stopToken) {
+        // An exception escaping a thread terminates the process, so report it and let the main loop close
+        try
+        {
+            RenderLoop(stopToken);
+        }
+        catch (const std::exception &e)
+        {
+            std::print("Render thread stopped: {}\n", e.what());
+            glfwSetWindowShouldClose(m_Window, GLFW_TRUE);
+            glfwPostEmptyEvent();
+        }
+    });
+
+    // The main thread only handles OS events and input from here on, so a
+    // slow frame or a window drag never delays input sampling
     while (!glfwWindowShouldClose(m_Window))
     {
-        m_Device.waitIdle();
-        glfwPollEvents();
-        while (m_Device.waitForFences(m_ExecutionFence, vk::True, 0) == vk::Result::eTimeout);
+        glfwWaitEvents();
+        m_InputBuffer.Publish(m_Input);
+    }
 
-        vk::ResultValue<uint32_t> imageIndex = m_Device.acquireNextImageKHR(m_Swapchain, UINT64_MAX, m_AcquireFrameSemaphores[m_CurrentFrame]);
+    renderThread.request_stop();
+    simulationThread.request_stop();
+}
+
+void App::RenderLoop(std::stop_token stopToken)
+{
+    TripleBuffer<FrameSnapshot> &snapshots = m_Simulation.GetSnapshots();
+    auto lastFrameStart = FramePacer::Clock::now();
+
+    while (!stopToken.stop_requested())
+    {
+        // Sleep before taking a snapshot so each frame is built from the freshest state
+        m_FramePacer.WaitForFrameStart(m_ExecutionFence);
+        snapshots.Update();
+        const FrameSnapshot &snapshot = snapshots.Front();
+        m_FramePacer.BeginFrame();
+
+        auto frameStart = FramePacer::Clock::now();
+        float deltaTime = std::min(std::chrono::duration<float>(frameStart - lastFrameStart).count(), 0.1f);
+        lastFrameStart = frameStart;
+
+        ApplyRenderRequests();
+        if (m_WindowResized || m_SwapchainDirty)
+        {
+            RecreateSwapchain();
+            continue;
+        }
+
+        while (m_Device.waitForFences(m_ExecutionFence, vk::True, UINT64_MAX) == vk::Result::eTimeout);
+
+        if (m_Settings.meshGridSize > 0)
+        {
+            m_MeshRenderer.CollectTimings();
+            if (m_Settings.benchmarkFrames > 0 && m_MeshRenderer.IsBenchmarkDone() && !glfwWindowShouldClose(m_Window))
+            {
+                glfwSetWindowShouldClose(m_Window, GLFW_TRUE);
+                glfwPostEmptyEvent();
+            }
+        }
+
+        // With exceptions enabled an out of date swapchain throws rather than returning eErrorOutOfDateKHR
+        vk::ResultValue<uint32_t> imageIndex(vk::Result::eErrorOutOfDateKHR, 0u);
+        try
+        {
+            imageIndex = m_Device.acquireNextImageKHR(m_Swapchain, UINT64_MAX, m_AcquireFrameSemaphores[m_CurrentFrame]);
+        }
+        catch (const vk::OutOfDateKHRError &)
+        {
+            // Recreated below along with the other out of date results
+        }
         if (imageIndex.result == vk::Result::eSuboptimalKHR || imageIndex.result == vk::Result::eErrorOutOfDateKHR)
         {
             std::print("Swapchain out of date! Recreating...\n");
-            DestroySwapchain();
-            CreateSwapchain();
+            RecreateSwapchain();
             continue;
         }
 
@@ -108,12 +179,24 @@ void App::Run()
 
         m_DrawBuffer.pipelineBarrier2(vk::DependencyInfo({ }, nullptr, nullptr, colorTransitionBarrier));
 
+        if (m_Settings.meshGridSize > 0)
+            m_MeshRenderer.BeginFrame(m_DrawBuffer);
+
         m_DrawBuffer.beginRendering(renderInfo);
 
+        if (m_Settings.meshGridSize > 0)
+            m_MeshRenderer.Draw(m_DrawBuffer);
+
         m_DrawBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_GraphicsPipeline);
 
+        ScenePushConstants pushConstants = { { snapshot.offset[0], snapshot.offset[1] }, snapshot.angle };
+        m_DrawBuffer.pushConstants<ScenePushConstants>(m_PipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, pushConstants);
+
         m_DrawBuffer.draw(3, 1, 0, 0);
 
+        if (m_Settings.particleCount > 0)
+            m_ParticleSystem.Draw(m_DrawBuffer);
+
         m_DrawBuffer.endRendering();
 
         vk::ImageMemoryBarrier2 presentTransitionBarrier(
@@ -132,32 +215,103 @@ void App::Run()
 
         m_DrawBuffer.end();
 
-        vk::SemaphoreSubmitInfo waitSemaphoreSubmitInfo(m_AcquireFrameSemaphores[m_CurrentFrame], 0, vk::PipelineStageFlagBits2::eTopOfPipe);
-        vk::SemaphoreSubmitInfo signalSemaphoreSubmitInfo(m_ReleaseFrameSemaphores[m_CurrentFrame], 0, vk::PipelineStageFlagBits2::eBottomOfPipe);
+        std::vector<vk::SemaphoreSubmitInfo> waitSemaphoreSubmitInfos = { vk::SemaphoreSubmitInfo(m_AcquireFrameSemaphores[m_CurrentFrame], 0, vk::PipelineStageFlagBits2::eTopOfPipe) };
+        // Nothing signals when a present is done with its semaphore, so each image gets its own. Once
+        // the same image is acquired again its previous present has finished waiting on it.
+        std::vector<vk::SemaphoreSubmitInfo> signalSemaphoreSubmitInfos = { vk::SemaphoreSubmitInfo(m_ReleaseFrameSemaphores[imageIndex.value], 0, vk::PipelineStageFlagBits2::eBottomOfPipe) };
         vk::CommandBufferSubmitInfo commandBufferSubmitInfo(m_DrawBuffer);
 
-        vk::SubmitInfo2 submitInfo({ }, waitSemaphoreSubmitInfo, commandBufferSubmitInfo, signalSemaphoreSubmitInfo);
+        // Kick off the next particle step so it overlaps with drawing the previous one
+        if (m_Settings.particleCount > 0)
+        {
+            m_ParticleSystem.Simulate(m_ComputeQueue, deltaTime);
+            waitSemaphoreSubmitInfos.push_back(m_ParticleSystem.GetDrawWaitInfo());
+            signalSemaphoreSubmitInfos.push_back(m_ParticleSystem.GetDrawSignalInfo());
+        }
+
+        vk::SubmitInfo2 submitInfo({ }, waitSemaphoreSubmitInfos, commandBufferSubmitInfo, signalSemaphoreSubmitInfos);
 
         m_GraphicsQueue.submit2(submitInfo, m_ExecutionFence);
+        m_FramePacer.EndCpuWork();
 
-        vk::Result result = m_PresentQueue.presentKHR(vk::PresentInfoKHR(m_ReleaseFrameSemaphores[m_CurrentFrame], m_Swapchain, imageIndex.value));
+        // Tag the present so the pacer can wait on it and read back when it hit the screen
+        vk::PresentInfoKHR presentInfo(m_ReleaseFrameSemaphores[imageIndex.value], m_Swapchain, imageIndex.value);
+        uint64_t presentId = 0;
+        vk::PresentIdKHR presentIdInfo(1, &presentId);
+        if (m_PresentWaitSupported)
+        {
+            presentId = m_FramePacer.NextPresentId();
+            presentInfo.pNext = &presentIdInfo;
+        }
+
+        vk::Result result = vk::Result::eErrorOutOfDateKHR;
+        try
+        {
+            result = m_PresentQueue.presentKHR(presentInfo);
+        }
+        catch (const vk::OutOfDateKHRError &)
+        {
+            // Recreated below along with the other out of date results
+        }
+        m_FramePacer.OnPresent();
         if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || m_WindowResized)
         {
-            m_WindowResized = false;
-            DestroySwapchain();
-            CreateSwapchain();
-            while (m_Device.waitForFences(m_ExecutionFence, vk::True, 1) == vk::Result::eTimeout) { }
-            DestroyPipeline();
-            CreatePipeline();
+            RecreateSwapchain();
             continue;
         }
         m_CurrentFrame = (m_CurrentFrame + 1) % m_SwapchainImages.size();
-        glfwSwapBuffers(m_Window);
     }
 
     m_Device.waitIdle();
 }
 
+void App::ApplyRenderRequests()
+{
+    // Requests are queued by the main thread and only applied here, so the
+    // render thread stays the sole owner of the swapchain and settings
+    constexpr vk::PresentModeKHR presentModes[] = {
+        vk::PresentModeKHR::eFifo,
+        vk::PresentModeKHR::eFifoRelaxed,
+        vk::PresentModeKHR::eMailbox,
+        vk::PresentModeKHR::eImmediate
+    };
+    int presentModeSteps = m_PresentModeSteps.exchange(0);
+    if (presentModeSteps > 0)
+    {
+        // Step from the mode in use rather than the requested one, which may be unsupported
+        size_t index = std::ranges::find(presentModes, m_PresentMode) - std::begin(presentModes);
+        for (size_t i = 1; presentModeSteps > 0 && i <= std::size(presentModes) * 4; i++)
+        {
+            vk::PresentModeKHR next = presentModes[(index + i) % std::size(presentModes)];
+            if (std::ranges::contains(m_AvailablePresentModes, next) && --presentModeSteps == 0)
+                m_Settings.presentMode = next;
+        }
+        m_SwapchainDirty = true;
+    }
+
+    int imageCountSteps = m_ImageCountSteps.exchange(0);
+    if (imageCountSteps != 0)
+    {
+        int imageCount = static_cast<int>(m_SwapchainImages.size()) + imageCountSteps;
+        m_Settings.swapchainImages = static_cast<uint32_t>(std::max(imageCount, 1));
+        m_SwapchainDirty = true;
+    }
+
+    if (m_TogglePacing.exchange(false))
+    {
+        m_FramePacer.SetPacingEnabled(!m_FramePacer.IsPacingEnabled());
+        std::print("Frame pacing {}\n", m_FramePacer.IsPacingEnabled() ? "enabled" : "disabled");
+    }
+
+    // The benchmark switches formats itself, so the toggle is ignored while it runs
+    if (m_ToggleVertexFormat.exchange(false) && m_Settings.meshGridSize > 0 && !m_MeshRenderer.IsBenchmarking())
+    {
+        bool quantized = m_MeshRenderer.GetVertexFormat() == VertexFormat::Quantized;
+        m_MeshRenderer.SetVertexFormat(quantized ? VertexFormat::Float : VertexFormat::Quantized);
+        std::print("Using {} vertices\n", quantized ? "float" : "quantized");
+    }
+}
+
 void App::InitGLFW()
 {
     if (glfwInit() == GLFW_FALSE)
@@ -171,7 +325,14 @@ void App::InitGLFW()
     if (!m_Window)
         throw std::runtime_error("Unable to create glfw window!");
     glfwSetWindowUserPointer(m_Window, this);
-    glfwSetWindowSizeCallback(m_Window, OnResize);
+    // The render thread can't query the window, so track the framebuffer size here
+    int width, height;
+    glfwGetFramebufferSize(m_Window, &width, &height);
+    m_FramebufferWidth = width;
+    m_FramebufferHeight = height;
+
+    glfwSetFramebufferSizeCallback(m_Window, OnResize);
+    glfwSetKeyCallback(m_Window, OnKey);
 }
 
 void App::InitVulkan()
@@ -266,18 +427,52 @@ void App::CreateDevice()
                     &priority));
     }
 
+    // Timeline semaphores order the compute and graphics queues
+    vk::PhysicalDeviceVulkan12Features vulkan12Features;
+    vulkan12Features.timelineSemaphore = vk::True;
+
     vk::PhysicalDeviceVulkan13Features vulkan13Features;
     vulkan13Features.dynamicRendering = vk::True;
     vulkan13Features.synchronization2 = vk::True;
 
     vk::PhysicalDeviceFeatures2 deviceFeatures;
 
-    vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features> chain = {
+    vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures;
+    presentIdFeatures.presentId = vk::True;
+    vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures;
+    presentWaitFeatures.presentWait = vk::True;
+
+    vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR> chain = {
         deviceFeatures,
-        vulkan13Features
+        vulkan12Features,
+        vulkan13Features,
+        presentIdFeatures,
+        presentWaitFeatures
     };
 
-    const char *deviceExtensions[] = { vk::KHRSwapchainExtensionName };
+    std::vector<const char *> deviceExtensions = { vk::KHRSwapchainExtensionName };
+
+    // Present id and present wait are optional, frame pacing falls back to timing estimates without them
+    std::vector<vk::ExtensionProperties> extensionProperties;
+    VK_CHECK_AND_SET(extensionProperties, m_PhysicalDevice.enumerateDeviceExtensionProperties(), "Unable to enumerate device extensions");
+    auto hasExtension = [&extensionProperties](const char *name) {
+        return std::ranges::any_of(extensionProperties, [&name](vk::ExtensionProperties const &property) { return strcmp(name, property.extensionName) == 0; });
+    };
+    auto supportedFeatures = m_PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR>();
+    m_PresentWaitSupported = hasExtension(vk::KHRPresentIdExtensionName) &&
+                             hasExtension(vk::KHRPresentWaitExtensionName) &&
+                             supportedFeatures.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId &&
+                             supportedFeatures.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+    if (m_PresentWaitSupported)
+    {
+        deviceExtensions.push_back(vk::KHRPresentIdExtensionName);
+        deviceExtensions.push_back(vk::KHRPresentWaitExtensionName);
+    }
+    else
+    {
+        chain.unlink<vk::PhysicalDevicePresentIdFeaturesKHR>();
+        chain.unlink<vk::PhysicalDevicePresentWaitFeaturesKHR>();
+    }
     vk::StructureChain<vk::DeviceCreateInfo, vk::PhysicalDeviceFeatures2> deviceCreateChain = {
         vk::DeviceCreateInfo(vk::DeviceCreateFlags(), queueCreateInfos, {}, deviceExtensions),
         chain.get<vk::PhysicalDeviceFeatures2>()
@@ -390,20 +585,18 @@ void App::CreateSwapchain()
         throw std::runtime_error("Image format not supprted");
     m_ColorAttachmentFormat = format;
 
-    // Setup double buffering
-    uint32_t minImageCount = 2;
+    // Use the requested image count, a max image count of 0 means there is no limit
+    uint32_t minImageCount = m_Settings.swapchainImages;
     if (minImageCount < surfaceCapabilities.minImageCount)
         minImageCount = surfaceCapabilities.minImageCount;
-    else if (minImageCount > surfaceCapabilities.maxImageCount)
+    else if (surfaceCapabilities.maxImageCount > 0 && minImageCount > surfaceCapabilities.maxImageCount)
         minImageCount = surfaceCapabilities.maxImageCount;
 
     auto extent = surfaceCapabilities.currentExtent;
     if (extent.width == std::numeric_limits<uint32_t>::max())
     {
-        int width, height;
-        glfwGetFramebufferSize(m_Window, &width, &height);
-        extent.width = std::clamp(static_cast<uint32_t>(width), surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width);
-        extent.height = std::clamp(static_cast<uint32_t>(height), surfaceCapabilities.minImageExtent.height, surfaceCapabilities.maxImageExtent.height);
+        extent.width = std::clamp(m_FramebufferWidth.load(), surfaceCapabilities.minImageExtent.width, surfaceCapabilities.maxImageExtent.width);
+        extent.height = std::clamp(m_FramebufferHeight.load(), surfaceCapabilities.minImageExtent.height, surfaceCapabilities.maxImageExtent.height);
     }
 
     // Keep track of the surface size internally
@@ -415,11 +608,12 @@ void App::CreateSwapchain()
         vk::SurfaceTransformFlagBitsKHR::eIdentity :
         surfaceCapabilities.currentTransform;
 
+    // Use the requested present mode and fallback to FIFO, which is always supported
     vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
-    if (std::any_of(availablePresentModes.begin(), 
-                    availablePresentModes.end(), 
-                    [] (vk::PresentModeKHR const &presentMode) { return presentMode == vk::PresentModeKHR::eMailbox; }))
-        presentMode = vk::PresentModeKHR::eMailbox;
+    if (std::ranges::contains(availablePresentModes, m_Settings.presentMode))
+        presentMode = m_Settings.presentMode;
+    m_PresentMode = presentMode;
+    m_AvailablePresentModes = availablePresentModes;
 
     vk::SwapchainKHR oldSwapchain = nullptr;
     if (m_Swapchain != nullptr)
@@ -474,6 +668,37 @@ void App::DestroySwapchain()
     m_SwapchainImages.clear();
 }
 
+void App::RecreateSwapchain()
+{
+    m_WindowResized = false;
+    m_SwapchainDirty = false;
+    m_Device.waitIdle();
+
+    DestroySwapchain();
+    CreateSwapchain();
+
+    // The image count may have changed, and a skipped acquire can leave a semaphore signaled
+    DestroyFrameSemaphores();
+    CreateFrameSemaphores();
+
+    DestroyPipeline();
+    CreatePipeline();
+    if (m_Settings.particleCount > 0)
+    {
+        m_ParticleSystem.DestroyPipeline();
+        m_ParticleSystem.CreatePipeline(m_ColorAttachmentFormat, m_Viewport, m_Scissor);
+    }
+    if (m_Settings.meshGridSize > 0)
+    {
+        m_MeshRenderer.DestroyPipeline();
+        m_MeshRenderer.CreatePipeline(m_ColorAttachmentFormat, m_Viewport, m_Scissor);
+    }
+
+    m_CurrentFrame = 0;
+    m_FramePacer.Reset(m_Swapchain, m_PresentMode);
+    std::print("Swapchain recreated with {} images in {} mode\n", m_SwapchainImages.size(), vk::to_string(m_PresentMode));
+}
+
 void App::CreatePipeline() 
 {
     // Setup Shader stages
@@ -508,7 +733,8 @@ void App::CreatePipeline()
     vk::PipelineColorBlendStateCreateInfo colorBlendCreateInfo({}, vk::False, vk::LogicOp::eCopy, colorBlendAttachmentState, {1.0f, 1.0f, 1.0f, 1.0f});
 
     // Create pipeline layout
-    vk::PipelineLayoutCreateInfo layoutCreateInfo({}, nullptr, nullptr);
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(ScenePushConstants));
+    vk::PipelineLayoutCreateInfo layoutCreateInfo({}, nullptr, pushConstantRange);
 
     m_PipelineLayout = m_Device.createPipelineLayout(layoutCreateInfo);
 
@@ -549,6 +775,41 @@ void App::SetupDraw()
 {
     m_CurrentFrame = 0;
 
+    CreateFrameSemaphores();
+
+    VK_CHECK_AND_SET(m_CommandPool, m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, m_DeviceScore.graphicsIndex)), "Unable to create command pool");
+    vk::CommandBufferAllocateInfo commandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1);
+    VK_CHECK_AND_SET(m_DrawBuffer, m_Device.allocateCommandBuffers(commandBufferAllocateInfo).front(), "Unable to allocate command buffers");
+    VK_CHECK_AND_SET(m_ExecutionFence, m_Device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled)), "Failed to create execution fence");
+
+    m_FramePacer.Init(m_Device, m_PresentWaitSupported, GetRefreshRate(), m_Settings.framePacing);
+    m_FramePacer.Reset(m_Swapchain, m_PresentMode);
+}
+
+void App::CreateParticles()
+{
+    if (m_Settings.particleCount == 0)
+        return;
+
+    m_ParticleSystem.Create(m_PhysicalDevice, m_Device, m_ComputeQueue, m_DeviceScore.graphicsIndex, m_DeviceScore.computeIndex, m_Settings.particleCount);
+    m_ParticleSystem.CreatePipeline(m_ColorAttachmentFormat, m_Viewport, m_Scissor);
+    std::print("Simulating {} particles on the compute queue\n", m_Settings.particleCount);
+}
+
+void App::CreateMeshes()
+{
+    if (m_Settings.meshGridSize == 0)
+        return;
+
+    VertexFormat format = m_Settings.quantizedVertices ? VertexFormat::Quantized : VertexFormat::Float;
+    m_MeshRenderer.Create(m_PhysicalDevice, m_Device, m_GraphicsQueue, m_DeviceScore.graphicsIndex, m_Settings.meshGridSize, format);
+    m_MeshRenderer.CreatePipeline(m_ColorAttachmentFormat, m_Viewport, m_Scissor);
+    if (m_Settings.benchmarkFrames > 0)
+        m_MeshRenderer.StartBenchmark(m_Settings.benchmarkFrames);
+}
+
+void App::CreateFrameSemaphores()
+{
     for (int i = 0; i < m_SwapchainImages.size(); i++)
     {
         vk::Semaphore semaphore;
@@ -557,19 +818,87 @@ void App::SetupDraw()
         VK_CHECK_AND_SET(semaphore, m_Device.createSemaphore({ }), "Unable to create semaphore");
         m_ReleaseFrameSemaphores.push_back(semaphore);
     }
+}
 
-    VK_CHECK_AND_SET(m_CommandPool, m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, m_DeviceScore.graphicsIndex)), "Unable to create command pool");
-    vk::CommandBufferAllocateInfo commandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1);
-    VK_CHECK_AND_SET(m_DrawBuffer, m_Device.allocateCommandBuffers(commandBufferAllocateInfo).front(), "Unable to allocate command buffers");
-    VK_CHECK_AND_SET(m_ExecutionFence, m_Device.createFence(vk::FenceCreateInfo(vk::FenceCreateFlagBits::eSignaled)), "Failed to create execution fence");
+void App::DestroyFrameSemaphores()
+{
+    for (const auto &semaphore : m_AcquireFrameSemaphores)
+        m_Device.destroySemaphore(semaphore);
+    for (const auto &semaphore : m_ReleaseFrameSemaphores)
+        m_Device.destroySemaphore(semaphore);
+
+    m_AcquireFrameSemaphores.clear();
+    m_ReleaseFrameSemaphores.clear();
+}
+
+double App::GetRefreshRate()
+{
+    GLFWmonitor *monitor = glfwGetWindowMonitor(m_Window);
+    if (!monitor)
+        monitor = glfwGetPrimaryMonitor();
+
+    const GLFWvidmode *videoMode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    return videoMode ? static_cast<double>(videoMode->refreshRate) : 60.0;
 }
 
 void App::OnResize(GLFWwindow *window, int width, int height)
 {
     App *pBlossom = static_cast<App *>(glfwGetWindowUserPointer(window));
+    pBlossom->m_FramebufferWidth = width;
+    pBlossom->m_FramebufferHeight = height;
     pBlossom->m_WindowResized = true;
 }
 
+void App::OnKey(GLFWwindow *window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_REPEAT)
+        return;
+
+    App *pBlossom = static_cast<App *>(glfwGetWindowUserPointer(window));
+    bool pressed = action == GLFW_PRESS;
+    InputState &input = pBlossom->m_Input;
+    switch (key)
+    {
+        case GLFW_KEY_A:
+        case GLFW_KEY_LEFT:
+            input.moveLeft = pressed;
+            break;
+        case GLFW_KEY_D:
+        case GLFW_KEY_RIGHT:
+            input.moveRight = pressed;
+            break;
+        case GLFW_KEY_W:
+        case GLFW_KEY_UP:
+            input.moveUp = pressed;
+            break;
+        case GLFW_KEY_S:
+        case GLFW_KEY_DOWN:
+            input.moveDown = pressed;
+            break;
+        // Cycle through the present modes supported by the surface
+        case GLFW_KEY_P:
+            if (pressed)
+                pBlossom->m_PresentModeSteps++;
+            break;
+        case GLFW_KEY_EQUAL:
+            if (pressed)
+                pBlossom->m_ImageCountSteps++;
+            break;
+        case GLFW_KEY_MINUS:
+            if (pressed)
+                pBlossom->m_ImageCountSteps--;
+            break;
+        case GLFW_KEY_L:
+            if (pressed)
+                pBlossom->m_TogglePacing = true;
+            break;
+        case GLFW_KEY_V:
+            if (pressed)
+                pBlossom->m_ToggleVertexFormat = true;
+            break;
+    }
+}
+
 void App::CreateShaders(const std::string &vertPath, const std::string &fragPath)
 {
     m_VertexShaderCode = LoadShader(vertPath);
@@ -581,23 +910,3 @@ void App::CreateShaders(const std::string &vertPath, const std::string &fragPath
     m_VertexShader = m_Device.createShaderModule(vertexShaderCreateInfo);
     m_FragmentShader = m_Device.createShaderModule(fragmentShaderCreateInfo);
 }
-
-std::vector<uint32_t> App::LoadShader(const std::string &path)
-{
-    std::ifstream shaderStream(path, std::ios::ate | std::ios::binary);
-    if (!shaderStream.is_open())
-    {
-        std::print("Unable to open file: {}\n", path);
-        exit(1);
-    }
-
-    size_t fileSize = (size_t) shaderStream.tellg();
-    shaderStream.seekg(0);
-
-    std::vector<uint32_t> shaderCode(fileSize / sizeof(uint32_t));
-
-    shaderStream.read(reinterpret_cast<char *>(shaderCode.data()), fileSize);
-    shaderStream.close();
-
-    return shaderCode;
-}
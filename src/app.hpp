@@ -5,6 +5,11 @@
 
 #include "settings.hpp"
 #include "utils.hpp"
+#include "frame_pacer.hpp"
+#include "simulation.hpp"
+#include "triple_buffer.hpp"
+#include "particle_system.hpp"
+#include "mesh_renderer.hpp"
 
 #include <vector>
 #include <set>
@@ -18,6 +23,8 @@
 #include <fstream>
 #include <unordered_map>
 #include <ranges>
+#include <atomic>
+#include <thread>
 
 enum class IndexTypes {
     GraphicsIndex,
@@ -44,13 +51,24 @@ struct DeviceScore
     }
 };
 
+// Per-draw scene state, matches the push constant block in res/shader.vert
+struct ScenePushConstants
+{
+    float offset[2];
+    float angle;
+};
+
 class App {
 public:
-    App();
+    App(const Settings &settings);
     ~App();
 
     void Run();
 private:
+    // Runs on the render thread, which owns all Vulkan submission
+    void RenderLoop(std::stop_token stopToken);
+    void ApplyRenderRequests();
+
     void InitGLFW();
     
     // Instance Initialization
@@ -67,9 +85,9 @@ private:
     void CreateSurface();
     void CreateSwapchain();
     void DestroySwapchain();
+    void RecreateSwapchain();
 
     void CreateShaders(const std::string &fragPath, const std::string &vertPath);
-    std::vector<uint32_t> LoadShader(const std::string &path);
 
     void CreatePipeline();
     void DestroyPipeline();
@@ -78,8 +96,14 @@ private:
 
     // Draw setup
     void SetupDraw();
+    void CreateParticles();
+    void CreateMeshes();
+    void CreateFrameSemaphores();
+    void DestroyFrameSemaphores();
+    double GetRefreshRate();
 
     static void OnResize(GLFWwindow *window, int width, int height);
+    static void OnKey(GLFWwindow *window, int key, int scancode, int action, int mods);
 
 private:
     GLFWwindow *m_Window;
@@ -90,6 +114,9 @@ private:
     vk::Device m_Device;
     vk::SurfaceKHR m_Surface;
     vk::SwapchainKHR m_Swapchain;
+    vk::PresentModeKHR m_PresentMode;
+    std::vector<vk::PresentModeKHR> m_AvailablePresentModes;
+    bool m_PresentWaitSupported;
     vk::Queue m_GraphicsQueue;
     vk::Queue m_PresentQueue;
     vk::Queue m_ComputeQueue;
@@ -102,7 +129,21 @@ private:
     vk::CommandBuffer m_DrawBuffer;
     vk::Fence m_ExecutionFence;
     uint32_t m_CurrentFrame;
-    bool m_WindowResized;
+    std::atomic<bool> m_WindowResized;
+    std::atomic<bool> m_SwapchainDirty;
+    std::atomic<uint32_t> m_FramebufferWidth;
+    std::atomic<uint32_t> m_FramebufferHeight;
+    // Runtime swapchain requests from the main thread
+    std::atomic<int> m_PresentModeSteps;
+    std::atomic<int> m_ImageCountSteps;
+    std::atomic<bool> m_TogglePacing;
+    std::atomic<bool> m_ToggleVertexFormat;
+    InputState m_Input;
+    TripleBuffer<InputState> m_InputBuffer;
+    Simulation m_Simulation;
+    ParticleSystem m_ParticleSystem;
+    MeshRenderer m_MeshRenderer;
+    FramePacer m_FramePacer;
     std::vector<uint32_t> m_VertexShaderCode;
     std::vector<uint32_t> m_FragmentShaderCode;
     vk::ShaderModule m_VertexShader;
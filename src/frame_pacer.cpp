@@ -0,0 +1,196 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <print>
+#include <string>
+#include <thread>
+
+// Time left before a vblank that is never handed to the CPU, covering GPU work
+// and the compositor.
+constexpr FramePacer::Duration SAFETY_MARGIN { 1.0 };
+// How long to wait for a single present before falling back to estimation.
+constexpr uint64_t PRESENT_WAIT_TIMEOUT = 100'000'000;
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(5);
+
+void FramePacer::Init(vk::Device device, bool presentWaitSupported, double refreshRate, bool pacingEnabled)
+{
+    m_Device = device;
+    m_PresentWaitSupported = presentWaitSupported;
+    m_PacingEnabled = pacingEnabled;
+    if (refreshRate > 0.0)
+        m_RefreshInterval = Duration(1000.0 / refreshRate);
+    m_Budget = m_RefreshInterval / 2.0;
+    m_LastReport = Clock::now();
+
+    std::print("Frame pacing using {} at {:.2f} Hz\n",
+            m_PresentWaitSupported ? "present wait" : "timing estimates",
+            1000.0 / m_RefreshInterval.count());
+}
+
+void FramePacer::Reset(vk::SwapchainKHR swapchain, vk::PresentModeKHR presentMode)
+{
+    // Present ids are tracked per swapchain, so start the sequence over
+    m_Swapchain = swapchain;
+    m_PresentMode = presentMode;
+    m_PresentId = 0;
+    m_HasPendingFrame = false;
+    m_HasLastPresent = false;
+}
+
+void FramePacer::WaitForFrameStart(vk::Fence executionFence)
+{
+    if (m_HasPendingFrame)
+    {
+        Clock::time_point presentTime;
+        if (!m_PresentWaitSupported || !WaitForPresent(m_PendingFrame.presentId, presentTime))
+            presentTime = EstimatePresentTime(executionFence);
+        RecordPresent(m_PendingFrame, presentTime);
+        m_HasPendingFrame = false;
+    }
+
+    m_CurrentFrame.hasTarget = false;
+    // Immediate mode asks for frames as fast as possible, so only measure it
+    if (!m_PacingEnabled || !m_HasLastPresent || m_PresentMode == vk::PresentModeKHR::eImmediate)
+        return;
+
+    // Aim for the earliest vblank we can still make and start as late as
+    // possible for it, so input is sampled right before the work begins
+    auto now = Clock::now();
+    auto interval = std::chrono::duration_cast<Clock::duration>(m_RefreshInterval);
+    auto budget = std::chrono::duration_cast<Clock::duration>(m_Budget);
+    auto targetVblank = m_LastPresent + interval;
+    while (targetVblank - budget < now)
+        targetVblank += interval;
+
+    auto startTime = targetVblank - budget;
+    auto coarseWake = startTime - std::chrono::milliseconds(1);
+    if (coarseWake > now)
+        std::this_thread::sleep_until(coarseWake);
+    while (Clock::now() < startTime)
+        std::this_thread::yield();
+
+    m_CurrentFrame.targetVblank = targetVblank;
+    m_CurrentFrame.hasTarget = true;
+}
+
+void FramePacer::BeginFrame()
+{
+    m_CurrentFrame.start = Clock::now();
+}
+
+void FramePacer::EndCpuWork()
+{
+    Duration cpuTime = Clock::now() - m_CurrentFrame.start;
+    m_CpuTime = m_CpuTime * 0.9 + cpuTime * 0.1;
+}
+
+uint64_t FramePacer::NextPresentId()
+{
+    return ++m_PresentId;
+}
+
+void FramePacer::OnPresent()
+{
+    m_CurrentFrame.presentId = m_PresentId;
+    m_PendingFrame = m_CurrentFrame;
+    m_HasPendingFrame = true;
+}
+
+bool FramePacer::WaitForPresent(uint64_t presentId, Clock::time_point &presentTime)
+{
+    vk::Result result;
+    try {
+        result = m_Device.waitForPresentKHR(m_Swapchain, presentId, PRESENT_WAIT_TIMEOUT);
+    }
+    catch (vk::SystemError &)
+    {
+        // The swapchain is about to be recreated, which resets the pacer
+        return false;
+    }
+
+    presentTime = Clock::now();
+    return result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR;
+}
+
+FramePacer::Clock::time_point FramePacer::EstimatePresentTime(vk::Fence executionFence)
+{
+    // Without present timing the best we know is when the GPU finished. Assume
+    // the image is shown on the next vblank of a grid anchored at the first frame.
+    // The grid's phase is made up, only a GPU finishing late is a real observation.
+    while (m_Device.waitForFences(executionFence, vk::True, UINT64_MAX) == vk::Result::eTimeout) { }
+    auto gpuDone = Clock::now();
+    if (!m_HasLastPresent)
+        return gpuDone;
+
+    auto interval = std::chrono::duration_cast<Clock::duration>(m_RefreshInterval);
+    auto elapsed = gpuDone - m_LastPresent;
+    auto vblanks = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(Duration(elapsed) / m_RefreshInterval)));
+    return m_LastPresent + interval * vblanks;
+}
+
+void FramePacer::RecordPresent(const FrameRecord &frame, Clock::time_point presentTime)
+{
+    // Refine the refresh interval from back to back presents
+    if (m_PresentWaitSupported && m_HasLastPresent)
+    {
+        Duration delta = presentTime - m_LastPresent;
+        if (delta > m_RefreshInterval * 0.75 && delta < m_RefreshInterval * 1.25)
+            m_RefreshInterval = m_RefreshInterval * 0.95 + delta * 0.05;
+    }
+
+    // Back off quickly after a missed vblank and creep back toward the
+    // measured CPU time while frames keep landing on time
+    bool missed = frame.hasTarget && Duration(presentTime - frame.targetVblank) > m_RefreshInterval / 2.0;
+    if (missed)
+    {
+        m_Budget += m_RefreshInterval / 4.0;
+        // Estimated present times can't tell a real miss from a wrong guess at the vblank phase
+        if (m_PresentWaitSupported)
+            m_MissedFrames++;
+    }
+    else
+    {
+        m_Budget -= Duration(0.05);
+    }
+    m_Budget = std::clamp(m_Budget, std::min(m_CpuTime + SAFETY_MARGIN, m_RefreshInterval), m_RefreshInterval);
+
+    double latency = Duration(presentTime - frame.start).count();
+    if (m_FrameCount == 0)
+    {
+        m_LatencyMin = latency;
+        m_LatencyMax = latency;
+    }
+    m_LatencyMin = std::min(m_LatencyMin, latency);
+    m_LatencyMax = std::max(m_LatencyMax, latency);
+    m_LatencySum += latency;
+    m_FrameCount++;
+
+    m_LastPresent = presentTime;
+    m_HasLastPresent = true;
+
+    if (presentTime - m_LastReport >= REPORT_INTERVAL)
+        ReportStats(presentTime);
+}
+
+void FramePacer::ReportStats(Clock::time_point now)
+{
+    double seconds = std::chrono::duration<double>(now - m_LastReport).count();
+    std::string missed = m_PresentWaitSupported ? std::format(", {} missed", m_MissedFrames) : std::string();
+    std::print("[{}] {:.1f} fps, {}latency avg {:.2f} ms (min {:.2f}, max {:.2f}), cpu {:.2f} ms, budget {:.2f} ms{}\n",
+            vk::to_string(m_PresentMode),
+            m_FrameCount / seconds,
+            m_PresentWaitSupported ? "" : "estimated ",
+            m_LatencySum / m_FrameCount,
+            m_LatencyMin,
+            m_LatencyMax,
+            m_CpuTime.count(),
+            m_Budget.count(),
+            missed);
+
+    m_LastReport = now;
+    m_FrameCount = 0;
+    m_MissedFrames = 0;
+    m_LatencySum = 0.0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+// Delays the start of each CPU frame so that its work finishes just before the
+// vblank it is presented on, rather than letting frames queue up ahead of the
+// display. Present times come from VK_KHR_present_wait when the device supports
+// it. Otherwise they are estimated from GPU completion and the refresh rate,
+// which says nothing about the real display phase, so the latency stats are
+// only estimates and missed vblanks are not counted.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::duration<double, std::milli>;
+
+    void Init(vk::Device device, bool presentWaitSupported, double refreshRate, bool pacingEnabled);
+    void Reset(vk::SwapchainKHR swapchain, vk::PresentModeKHR presentMode);
+
+    // Waits for the previous frame to be presented and then sleeps until the
+    // next frame should start. The fence guards the previous frame's submission.
+    void WaitForFrameStart(vk::Fence executionFence);
+    void BeginFrame();
+    void EndCpuWork();
+
+    // Id to chain into vk::PresentIdKHR for the frame being presented. Only
+    // meaningful when UsesPresentWait() is true.
+    uint64_t NextPresentId();
+    void OnPresent();
+
+    bool UsesPresentWait() const { return m_PresentWaitSupported; }
+    bool IsPacingEnabled() const { return m_PacingEnabled; }
+    void SetPacingEnabled(bool enabled) { m_PacingEnabled = enabled; }
+
+private:
+    struct FrameRecord {
+        uint64_t presentId = 0;
+        Clock::time_point start;
+        Clock::time_point targetVblank;
+        bool hasTarget = false;
+    };
+
+    bool WaitForPresent(uint64_t presentId, Clock::time_point &presentTime);
+    Clock::time_point EstimatePresentTime(vk::Fence executionFence);
+    void RecordPresent(const FrameRecord &frame, Clock::time_point presentTime);
+    void ReportStats(Clock::time_point now);
+
+private:
+    vk::Device m_Device;
+    vk::SwapchainKHR m_Swapchain;
+    vk::PresentModeKHR m_PresentMode = vk::PresentModeKHR::eFifo;
+    bool m_PresentWaitSupported = false;
+    bool m_PacingEnabled = true;
+
+    uint64_t m_PresentId = 0;
+    FrameRecord m_CurrentFrame;
+    FrameRecord m_PendingFrame;
+    bool m_HasPendingFrame = false;
+
+    // Display timing model
+    Duration m_RefreshInterval { 1000.0 / 60.0 };
+    Duration m_Budget { 1000.0 / 120.0 };
+    Duration m_CpuTime { 0.0 };
+    Clock::time_point m_LastPresent;
+    bool m_HasLastPresent = false;
+
+    // Latency statistics, reset after every report
+    Clock::time_point m_LastReport;
+    uint32_t m_FrameCount = 0;
+    uint32_t m_MissedFrames = 0;
+    double m_LatencySum = 0.0;
+    double m_LatencyMin = 0.0;
+    double m_LatencyMax = 0.0;
+};
@@ -0,0 +1,74 @@
+#include "mesh.hpp"
+
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+Mesh GenerateSphere(uint32_t rings, uint32_t segments)
+{
+    Mesh mesh;
+    mesh.vertices.reserve((rings + 1) * (segments + 1));
+    mesh.indices.reserve(rings * segments * 6);
+
+    // Duplicate the seam column so uvs wrap cleanly
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        float v = static_cast<float>(ring) / rings;
+        float theta = v * std::numbers::pi_v<float>;
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            float u = static_cast<float>(segment) / segments;
+            float phi = u * 2.0f * std::numbers::pi_v<float>;
+
+            Vertex vertex;
+            vertex.position[0] = std::sin(theta) * std::cos(phi);
+            vertex.position[1] = std::cos(theta);
+            vertex.position[2] = std::sin(theta) * std::sin(phi);
+            vertex.normal[0] = vertex.position[0];
+            vertex.normal[1] = vertex.position[1];
+            vertex.normal[2] = vertex.position[2];
+            vertex.tangent[0] = -std::sin(phi);
+            vertex.tangent[1] = 0.0f;
+            vertex.tangent[2] = std::cos(phi);
+            vertex.tangent[3] = 1.0f;
+            vertex.uv[0] = u;
+            vertex.uv[1] = v;
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    auto addTriangle = [&mesh](uint32_t a, uint32_t b, uint32_t c) {
+        // Flip any triangle whose face normal points into the sphere
+        const float *pa = mesh.vertices[a].position;
+        const float *pb = mesh.vertices[b].position;
+        const float *pc = mesh.vertices[c].position;
+        float ab[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+        float ac[3] = { pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2] };
+        float normal[3] = {
+            ab[1] * ac[2] - ab[2] * ac[1],
+            ab[2] * ac[0] - ab[0] * ac[2],
+            ab[0] * ac[1] - ab[1] * ac[0]
+        };
+        float facing = normal[0] * (pa[0] + pb[0] + pc[0]) + normal[1] * (pa[1] + pb[1] + pc[1]) + normal[2] * (pa[2] + pb[2] + pc[2]);
+        if (facing < 0.0f)
+            std::swap(b, c);
+        mesh.indices.insert(mesh.indices.end(), { a, b, c });
+    };
+
+    uint32_t stride = segments + 1;
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            uint32_t topLeft = ring * stride + segment;
+            uint32_t bottomLeft = topLeft + stride;
+            // The poles collapse one triangle of each quad, skip it
+            if (ring != 0)
+                addTriangle(topLeft, bottomLeft, topLeft + 1);
+            if (ring != rings - 1)
+                addTriangle(topLeft + 1, bottomLeft, bottomLeft + 1);
+        }
+    }
+
+    return mesh;
+}
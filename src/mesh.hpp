@@ -0,0 +1,15 @@
+#pragma once
+
+#include "vertex_encoding.hpp"
+
+#include <cstdint>
+#include <vector>
+
+struct Mesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// Unit sphere with triangles wound counter-clockwise when seen from outside
+Mesh GenerateSphere(uint32_t rings, uint32_t segments);
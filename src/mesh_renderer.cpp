@@ -0,0 +1,277 @@
+#include "mesh_renderer.hpp"
+#include "mesh.hpp"
+#include "utils.hpp"
+
+#include <cstring>
+
+constexpr uint32_t SPHERE_RINGS = 128;
+constexpr uint32_t SPHERE_SEGMENTS = 256;
+// Frames dropped at the start of each benchmark pass while clocks and caches settle
+constexpr uint32_t BENCHMARK_WARMUP_FRAMES = 16;
+
+static const char *VertexFormatName(VertexFormat format)
+{
+    return format == VertexFormat::Float ? "float" : "quantized";
+}
+
+void MeshRenderer::Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue graphicsQueue, uint32_t graphicsIndex, uint32_t gridSize, VertexFormat format)
+{
+    m_PhysicalDevice = physicalDevice;
+    m_Device = device;
+    m_GraphicsQueue = graphicsQueue;
+    m_GraphicsIndex = graphicsIndex;
+    m_GridSize = gridSize;
+    m_Format = format;
+
+    // Encode the same mesh in both layouts
+    Mesh sphere = GenerateSphere(SPHERE_RINGS, SPHERE_SEGMENTS);
+    m_Bounds = ComputeBounds(sphere.vertices);
+    std::vector<QuantizedVertex> quantizedVertices = QuantizeVertices(sphere.vertices, m_Bounds);
+    m_VertexCount = static_cast<uint32_t>(sphere.vertices.size());
+    m_IndexCount = static_cast<uint32_t>(sphere.indices.size());
+
+    VertexBuffer &floatBuffer = m_VertexBuffers[static_cast<size_t>(VertexFormat::Float)];
+    floatBuffer.size = sphere.vertices.size() * sizeof(Vertex);
+    UploadBuffer(sphere.vertices.data(), floatBuffer.size, vk::BufferUsageFlagBits::eStorageBuffer, floatBuffer.buffer, floatBuffer.memory);
+
+    VertexBuffer &quantizedBuffer = m_VertexBuffers[static_cast<size_t>(VertexFormat::Quantized)];
+    quantizedBuffer.size = quantizedVertices.size() * sizeof(QuantizedVertex);
+    UploadBuffer(quantizedVertices.data(), quantizedBuffer.size, vk::BufferUsageFlagBits::eStorageBuffer, quantizedBuffer.buffer, quantizedBuffer.memory);
+
+    UploadBuffer(sphere.indices.data(), sphere.indices.size() * sizeof(uint32_t), vk::BufferUsageFlagBits::eIndexBuffer, m_IndexBuffer, m_IndexMemory);
+
+    std::print("Mesh vertex memory: {} KiB as float, {} KiB quantized\n", floatBuffer.size / 1024, quantizedBuffer.size / 1024);
+
+    // Vertices are pulled from a storage buffer, one set per layout
+    vk::DescriptorSetLayoutBinding binding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eVertex);
+    VK_CHECK_AND_SET(m_SetLayout, m_Device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({ }, binding)), "Unable to create mesh set layout");
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, FORMAT_COUNT);
+    VK_CHECK_AND_SET(m_DescriptorPool, m_Device.createDescriptorPool(vk::DescriptorPoolCreateInfo({ }, FORMAT_COUNT, poolSize)), "Unable to create mesh descriptor pool");
+
+    std::array<vk::DescriptorSetLayout, FORMAT_COUNT> setLayouts;
+    setLayouts.fill(m_SetLayout);
+    std::vector<vk::DescriptorSet> sets;
+    VK_CHECK_AND_SET(sets, m_Device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_DescriptorPool, setLayouts)), "Unable to allocate mesh descriptor sets");
+    for (uint32_t i = 0; i < FORMAT_COUNT; i++)
+    {
+        m_VertexBuffers[i].descriptorSet = sets[i];
+        vk::DescriptorBufferInfo bufferInfo(m_VertexBuffers[i].buffer, 0, vk::WholeSize);
+        m_Device.updateDescriptorSets(vk::WriteDescriptorSet(sets[i], 0, 0, vk::DescriptorType::eStorageBuffer, nullptr, bufferInfo), nullptr);
+    }
+
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(MeshPushConstants));
+    VK_CHECK_AND_SET(m_PipelineLayout, m_Device.createPipelineLayout(vk::PipelineLayoutCreateInfo({ }, m_SetLayout, pushConstantRange)), "Unable to create mesh pipeline layout");
+
+    // Timestamps bracket the mesh draw
+    m_TimestampsSupported = m_PhysicalDevice.getQueueFamilyProperties()[graphicsIndex].timestampValidBits > 0;
+    m_TimestampPeriod = m_PhysicalDevice.getProperties().limits.timestampPeriod;
+    if (m_TimestampsSupported)
+        VK_CHECK_AND_SET(m_QueryPool, m_Device.createQueryPool(vk::QueryPoolCreateInfo({ }, vk::QueryType::eTimestamp, 2)), "Unable to create mesh query pool");
+}
+
+void MeshRenderer::Destroy()
+{
+    DestroyPipeline();
+
+    m_Device.destroyQueryPool(m_QueryPool);
+    m_Device.destroyPipelineLayout(m_PipelineLayout);
+    m_Device.destroyDescriptorPool(m_DescriptorPool);
+    m_Device.destroyDescriptorSetLayout(m_SetLayout);
+
+    for (const auto &vertexBuffer : m_VertexBuffers)
+    {
+        m_Device.destroyBuffer(vertexBuffer.buffer);
+        m_Device.freeMemory(vertexBuffer.memory);
+    }
+    m_Device.destroyBuffer(m_IndexBuffer);
+    m_Device.freeMemory(m_IndexMemory);
+}
+
+void MeshRenderer::UploadBuffer(const void *data, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::Buffer &buffer, vk::DeviceMemory &memory)
+{
+    vk::Buffer stagingBuffer;
+    vk::DeviceMemory stagingMemory;
+    CreateBuffer(m_PhysicalDevice, m_Device, size, vk::BufferUsageFlagBits::eTransferSrc,
+            vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+            stagingBuffer, stagingMemory);
+    void *mapped;
+    VK_CHECK_AND_SET(mapped, m_Device.mapMemory(stagingMemory, 0, size), "Unable to map staging memory");
+    memcpy(mapped, data, size);
+    m_Device.unmapMemory(stagingMemory);
+
+    CreateBuffer(m_PhysicalDevice, m_Device, size, usage | vk::BufferUsageFlagBits::eTransferDst,
+            vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, memory);
+
+    vk::CommandPool commandPool;
+    VK_CHECK_AND_SET(commandPool, m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eTransient, m_GraphicsIndex)), "Unable to create upload command pool");
+    vk::CommandBuffer commandBuffer;
+    VK_CHECK_AND_SET(commandBuffer, m_Device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(commandPool, vk::CommandBufferLevel::ePrimary, 1)).front(), "Unable to allocate upload command buffer");
+
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    commandBuffer.copyBuffer(stagingBuffer, buffer, vk::BufferCopy(0, 0, size));
+    commandBuffer.end();
+
+    vk::CommandBufferSubmitInfo commandBufferSubmitInfo(commandBuffer);
+    m_GraphicsQueue.submit2(vk::SubmitInfo2({ }, nullptr, commandBufferSubmitInfo, nullptr));
+    m_GraphicsQueue.waitIdle();
+
+    m_Device.destroyCommandPool(commandPool);
+    m_Device.destroyBuffer(stagingBuffer);
+    m_Device.freeMemory(stagingMemory);
+}
+
+void MeshRenderer::CreatePipeline(vk::Format colorFormat, const vk::Viewport &viewport, const vk::Rect2D &scissor)
+{
+    const char *vertexShaderPaths[FORMAT_COUNT] = { "res/mesh_float.vert.spv", "res/mesh_quantized.vert.spv" };
+    vk::ShaderModule fragmentShader = CreateShaderModule(m_Device, "res/mesh.frag.spv");
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputCreateInfo({}, nullptr, nullptr);
+    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo({}, vk::PrimitiveTopology::eTriangleList, vk::False);
+    vk::PipelineViewportStateCreateInfo viewportStateCreateInfo({}, viewport, scissor);
+    // There is no depth buffer, so back faces have to be culled for the spheres to look solid
+    vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo({}, vk::False, vk::False, vk::PolygonMode::eFill, vk::CullModeFlagBits::eBack, vk::FrontFace::eCounterClockwise, vk::False, 0, 0, 0, 1.0);
+    vk::PipelineMultisampleStateCreateInfo multisampleStateCreateInfo({}, vk::SampleCountFlagBits::e1, vk::False);
+    vk::PipelineColorBlendAttachmentState colorBlendAttachmentState(vk::False, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
+    vk::PipelineColorBlendStateCreateInfo colorBlendCreateInfo({}, vk::False, vk::LogicOp::eCopy, colorBlendAttachmentState, {1.0f, 1.0f, 1.0f, 1.0f});
+    vk::PipelineRenderingCreateInfo renderingCreateInfo(0, colorFormat);
+
+    for (uint32_t i = 0; i < FORMAT_COUNT; i++)
+    {
+        vk::ShaderModule vertexShader = CreateShaderModule(m_Device, vertexShaderPaths[i]);
+        std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStageCreateInfos = {
+            vk::PipelineShaderStageCreateInfo({ }, vk::ShaderStageFlagBits::eVertex, vertexShader, "main"),
+            vk::PipelineShaderStageCreateInfo({ }, vk::ShaderStageFlagBits::eFragment, fragmentShader, "main")
+        };
+
+        vk::GraphicsPipelineCreateInfo pipelineCreateInfo({}, shaderStageCreateInfos, &vertexInputCreateInfo, &inputAssemblyCreateInfo, nullptr, &viewportStateCreateInfo, &rasterizationStateCreateInfo, &multisampleStateCreateInfo, nullptr, &colorBlendCreateInfo, nullptr, m_PipelineLayout);
+        vk::StructureChain<vk::GraphicsPipelineCreateInfo, vk::PipelineRenderingCreateInfo> pipelineChain(pipelineCreateInfo, renderingCreateInfo);
+
+        auto pipelineResult = m_Device.createGraphicsPipeline(nullptr, pipelineChain.get<vk::GraphicsPipelineCreateInfo>());
+        m_Device.destroyShaderModule(vertexShader);
+        if (pipelineResult.result != vk::Result::eSuccess)
+            throw std::runtime_error("Unable to create mesh pipeline!");
+        m_VertexBuffers[i].pipeline = pipelineResult.value;
+    }
+
+    m_Device.destroyShaderModule(fragmentShader);
+}
+
+void MeshRenderer::DestroyPipeline()
+{
+    for (auto &vertexBuffer : m_VertexBuffers)
+    {
+        m_Device.destroyPipeline(vertexBuffer.pipeline);
+        vertexBuffer.pipeline = nullptr;
+    }
+}
+
+void MeshRenderer::BeginFrame(vk::CommandBuffer commandBuffer)
+{
+    if (m_TimestampsSupported)
+        commandBuffer.resetQueryPool(m_QueryPool, 0, 2);
+}
+
+void MeshRenderer::Draw(vk::CommandBuffer commandBuffer)
+{
+    const VertexBuffer &vertexBuffer = m_VertexBuffers[static_cast<size_t>(m_Format)];
+    MeshPushConstants pushConstants = {
+        { m_Bounds.min[0], m_Bounds.min[1], m_Bounds.min[2] },
+        m_GridSize,
+        { m_Bounds.extent[0], m_Bounds.extent[1], m_Bounds.extent[2] }
+    };
+
+    if (m_TimestampsSupported)
+        commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, m_QueryPool, 0);
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, vertexBuffer.pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_PipelineLayout, 0, vertexBuffer.descriptorSet, nullptr);
+    commandBuffer.bindIndexBuffer(m_IndexBuffer, 0, vk::IndexType::eUint32);
+    commandBuffer.pushConstants<MeshPushConstants>(m_PipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, pushConstants);
+    commandBuffer.drawIndexed(m_IndexCount, m_GridSize * m_GridSize, 0, 0, 0);
+
+    if (m_TimestampsSupported)
+    {
+        commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, m_QueryPool, 1);
+        m_QueryPending = true;
+        m_QueryFormat = m_Format;
+    }
+}
+
+void MeshRenderer::CollectTimings()
+{
+    if (!m_QueryPending)
+        return;
+    m_QueryPending = false;
+
+    // Each query is followed by its availability
+    auto results = m_Device.getQueryPoolResults<uint64_t>(m_QueryPool, 0, 2, 4 * sizeof(uint64_t), 2 * sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+    if (results.result != vk::Result::eSuccess || !results.value[1] || !results.value[3])
+        return;
+
+    double gpuTime = static_cast<double>(results.value[2] - results.value[0]) * m_TimestampPeriod / 1e6;
+    m_LastGpuTime = gpuTime;
+    if (!m_Benchmarking)
+        return;
+
+    if (m_BenchmarkSamples++ >= BENCHMARK_WARMUP_FRAMES)
+        m_GpuTimeSums[static_cast<size_t>(m_QueryFormat)] += gpuTime;
+
+    if (m_BenchmarkSamples < m_BenchmarkFrames + BENCHMARK_WARMUP_FRAMES)
+        return;
+
+    // Float runs first, then the quantized layout
+    m_BenchmarkSamples = 0;
+    if (m_Format == VertexFormat::Float)
+    {
+        m_Format = VertexFormat::Quantized;
+        return;
+    }
+
+    ReportBenchmark();
+    m_Benchmarking = false;
+    m_BenchmarkDone = true;
+}
+
+void MeshRenderer::StartBenchmark(uint32_t frames)
+{
+    if (!m_TimestampsSupported)
+    {
+        std::print("Timestamps are not supported on the graphics queue, skipping vertex benchmark\n");
+        m_BenchmarkDone = true;
+        return;
+    }
+
+    m_BenchmarkFrames = frames;
+    m_BenchmarkSamples = 0;
+    m_GpuTimeSums = { };
+    m_Format = VertexFormat::Float;
+    m_Benchmarking = true;
+    m_BenchmarkDone = false;
+}
+
+void MeshRenderer::ReportBenchmark()
+{
+    const VertexBuffer &floatBuffer = m_VertexBuffers[static_cast<size_t>(VertexFormat::Float)];
+    const VertexBuffer &quantizedBuffer = m_VertexBuffers[static_cast<size_t>(VertexFormat::Quantized)];
+    double floatTime = m_GpuTimeSums[static_cast<size_t>(VertexFormat::Float)] / m_BenchmarkFrames;
+    double quantizedTime = m_GpuTimeSums[static_cast<size_t>(VertexFormat::Quantized)] / m_BenchmarkFrames;
+    // Every instance pulls every vertex again
+    uint64_t verticesPerFrame = static_cast<uint64_t>(m_VertexCount) * m_GridSize * m_GridSize;
+
+    std::print("Vertex benchmark: {} frames, {} vertices and {} triangles per frame\n", m_BenchmarkFrames, verticesPerFrame, static_cast<uint64_t>(m_IndexCount / 3) * m_GridSize * m_GridSize);
+    for (auto format : { VertexFormat::Float, VertexFormat::Quantized })
+    {
+        const VertexBuffer &vertexBuffer = m_VertexBuffers[static_cast<size_t>(format)];
+        double gpuTime = m_GpuTimeSums[static_cast<size_t>(format)] / m_BenchmarkFrames;
+        std::print("  {:<9} {:>2} bytes/vertex, {:>6} KiB, {:>8.1f} MiB fetched/frame, {:.3f} ms\n",
+                VertexFormatName(format),
+                vertexBuffer.size / m_VertexCount,
+                vertexBuffer.size / 1024,
+                static_cast<double>(vertexBuffer.size / m_VertexCount * verticesPerFrame) / (1024.0 * 1024.0),
+                gpuTime);
+    }
+    std::print("  quantized uses {:.1f}% of the vertex memory and takes {:.1f}% of the GPU time\n",
+            100.0 * quantizedBuffer.size / floatBuffer.size,
+            100.0 * quantizedTime / floatTime);
+}
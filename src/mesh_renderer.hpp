@@ -0,0 +1,97 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+
+#include "vertex_encoding.hpp"
+
+#include <array>
+#include <cstdint>
+
+enum class VertexFormat {
+    Float,
+    Quantized
+};
+
+// Matches MeshParams in res/mesh_common.glsl
+struct MeshPushConstants
+{
+    float boundsMin[3];
+    uint32_t gridSize;
+    float boundsExtent[3];
+};
+
+// Draws a grid of instanced spheres whose vertices are pulled from a storage
+// buffer in the vertex shader. The same mesh is kept in both the full float
+// and the quantized layout so they can be switched and compared at runtime.
+class MeshRenderer {
+public:
+    void Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue graphicsQueue, uint32_t graphicsIndex, uint32_t gridSize, VertexFormat format);
+    void Destroy();
+
+    void CreatePipeline(vk::Format colorFormat, const vk::Viewport &viewport, const vk::Rect2D &scissor);
+    void DestroyPipeline();
+
+    // Resets the timestamp queries, must be recorded outside of rendering
+    void BeginFrame(vk::CommandBuffer commandBuffer);
+    void Draw(vk::CommandBuffer commandBuffer);
+    // Reads back the timestamps of the last submitted frame once its fence has signaled
+    void CollectTimings();
+
+    VertexFormat GetVertexFormat() const { return m_Format; }
+    void SetVertexFormat(VertexFormat format) { m_Format = format; }
+
+    // Times the given number of frames with each vertex format and prints a comparison
+    void StartBenchmark(uint32_t frames);
+    // GPU time of the last collected mesh draw in ms, or 0 without timestamp support
+    double GetLastGpuTime() const { return m_LastGpuTime; }
+
+    bool IsBenchmarking() const { return m_Benchmarking; }
+    bool IsBenchmarkDone() const { return m_BenchmarkDone; }
+
+private:
+    struct VertexBuffer {
+        vk::Buffer buffer;
+        vk::DeviceMemory memory;
+        vk::DeviceSize size = 0;
+        vk::DescriptorSet descriptorSet;
+        vk::Pipeline pipeline;
+    };
+
+    void UploadBuffer(const void *data, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::Buffer &buffer, vk::DeviceMemory &memory);
+    void ReportBenchmark();
+
+private:
+    static constexpr uint32_t FORMAT_COUNT = 2;
+
+    vk::PhysicalDevice m_PhysicalDevice;
+    vk::Device m_Device;
+    vk::Queue m_GraphicsQueue;
+    uint32_t m_GraphicsIndex = 0;
+
+    std::array<VertexBuffer, FORMAT_COUNT> m_VertexBuffers;
+    vk::Buffer m_IndexBuffer;
+    vk::DeviceMemory m_IndexMemory;
+    uint32_t m_IndexCount = 0;
+    uint32_t m_VertexCount = 0;
+    MeshBounds m_Bounds;
+    uint32_t m_GridSize = 0;
+    VertexFormat m_Format = VertexFormat::Quantized;
+
+    vk::DescriptorSetLayout m_SetLayout;
+    vk::DescriptorPool m_DescriptorPool;
+    vk::PipelineLayout m_PipelineLayout;
+
+    // GPU timing of the mesh draw
+    vk::QueryPool m_QueryPool;
+    bool m_TimestampsSupported = false;
+    bool m_QueryPending = false;
+    VertexFormat m_QueryFormat = VertexFormat::Quantized;
+    double m_TimestampPeriod = 1.0;
+    double m_LastGpuTime = 0.0;
+
+    uint32_t m_BenchmarkFrames = 0;
+    uint32_t m_BenchmarkSamples = 0;
+    bool m_Benchmarking = false;
+    bool m_BenchmarkDone = false;
+    std::array<double, FORMAT_COUNT> m_GpuTimeSums = { };
+};
@@ -0,0 +1,298 @@
+#include "particle_system.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+constexpr uint32_t WORKGROUP_SIZE = 256;
+// Average particle lifetime in seconds, keep in sync with res/particle_emit.comp
+constexpr float AVERAGE_LIFETIME = 3.0f;
+
+void ParticleSystem::Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue computeQueue, uint32_t graphicsIndex, uint32_t computeIndex, uint32_t capacity)
+{
+    m_PhysicalDevice = physicalDevice;
+    m_Device = device;
+    m_Capacity = capacity;
+
+    CreateBuffers(graphicsIndex, computeIndex);
+    CreateDescriptors();
+    CreateComputePipelines();
+
+    VK_CHECK_AND_SET(m_CommandPool, m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, computeIndex)), "Unable to create particle command pool");
+    vk::CommandBufferAllocateInfo commandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, STATE_COUNT);
+    std::vector<vk::CommandBuffer> commandBuffers;
+    VK_CHECK_AND_SET(commandBuffers, m_Device.allocateCommandBuffers(commandBufferAllocateInfo), "Unable to allocate particle command buffers");
+    std::ranges::copy(commandBuffers, m_CommandBuffers.begin());
+
+    vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> timelineChain = {
+        vk::SemaphoreCreateInfo(),
+        vk::SemaphoreTypeCreateInfo(vk::SemaphoreType::eTimeline, 0)
+    };
+    VK_CHECK_AND_SET(m_ComputeTimeline, m_Device.createSemaphore(timelineChain.get<vk::SemaphoreCreateInfo>()), "Unable to create compute timeline semaphore");
+    VK_CHECK_AND_SET(m_GraphicsTimeline, m_Device.createSemaphore(timelineChain.get<vk::SemaphoreCreateInfo>()), "Unable to create graphics timeline semaphore");
+
+    ClearState(computeQueue);
+}
+
+void ParticleSystem::Destroy()
+{
+    DestroyPipeline();
+
+    m_Device.destroySemaphore(m_ComputeTimeline);
+    m_Device.destroySemaphore(m_GraphicsTimeline);
+    m_Device.destroyCommandPool(m_CommandPool);
+
+    m_Device.destroyPipeline(m_SimulatePipeline);
+    m_Device.destroyPipeline(m_EmitPipeline);
+    m_Device.destroyPipeline(m_FinalizePipeline);
+    m_Device.destroyPipelineLayout(m_ComputeLayout);
+
+    m_Device.destroyDescriptorPool(m_DescriptorPool);
+    m_Device.destroyDescriptorSetLayout(m_ComputeSetLayout);
+    m_Device.destroyDescriptorSetLayout(m_DrawSetLayout);
+
+    for (uint32_t i = 0; i < STATE_COUNT; i++)
+    {
+        m_Device.destroyBuffer(m_ParticleBuffers[i]);
+        m_Device.freeMemory(m_ParticleMemory[i]);
+        m_Device.destroyBuffer(m_CounterBuffers[i]);
+        m_Device.freeMemory(m_CounterMemory[i]);
+    }
+}
+
+void ParticleSystem::CreateBuffers(uint32_t graphicsIndex, uint32_t computeIndex)
+{
+    // Both queues touch every buffer, share them instead of transferring ownership each step
+    std::vector<uint32_t> queueFamilies = { graphicsIndex };
+    if (computeIndex != graphicsIndex)
+        queueFamilies.push_back(computeIndex);
+
+    for (uint32_t i = 0; i < STATE_COUNT; i++)
+    {
+        CreateBuffer(m_PhysicalDevice, m_Device,
+                static_cast<vk::DeviceSize>(m_Capacity) * sizeof(Particle),
+                vk::BufferUsageFlagBits::eStorageBuffer,
+                vk::MemoryPropertyFlagBits::eDeviceLocal,
+                m_ParticleBuffers[i], m_ParticleMemory[i], queueFamilies);
+        CreateBuffer(m_PhysicalDevice, m_Device,
+                sizeof(ParticleCounters),
+                vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                vk::MemoryPropertyFlagBits::eDeviceLocal,
+                m_CounterBuffers[i], m_CounterMemory[i], queueFamilies);
+    }
+}
+
+void ParticleSystem::CreateDescriptors()
+{
+    // Compute reads the source state and appends into the destination state
+    std::array<vk::DescriptorSetLayoutBinding, 4> computeBindings;
+    for (uint32_t binding = 0; binding < computeBindings.size(); binding++)
+        computeBindings[binding] = vk::DescriptorSetLayoutBinding(binding, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute);
+    VK_CHECK_AND_SET(m_ComputeSetLayout, m_Device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({ }, computeBindings)), "Unable to create particle compute set layout");
+
+    // Drawing pulls particles straight from the state buffer
+    vk::DescriptorSetLayoutBinding drawBinding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eVertex);
+    VK_CHECK_AND_SET(m_DrawSetLayout, m_Device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo({ }, drawBinding)), "Unable to create particle draw set layout");
+
+    vk::DescriptorPoolSize poolSize(vk::DescriptorType::eStorageBuffer, STATE_COUNT * (computeBindings.size() + 1));
+    VK_CHECK_AND_SET(m_DescriptorPool, m_Device.createDescriptorPool(vk::DescriptorPoolCreateInfo({ }, STATE_COUNT * 2, poolSize)), "Unable to create particle descriptor pool");
+
+    std::array<vk::DescriptorSetLayout, STATE_COUNT> computeLayouts;
+    std::array<vk::DescriptorSetLayout, STATE_COUNT> drawLayouts;
+    computeLayouts.fill(m_ComputeSetLayout);
+    drawLayouts.fill(m_DrawSetLayout);
+
+    std::vector<vk::DescriptorSet> sets;
+    VK_CHECK_AND_SET(sets, m_Device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_DescriptorPool, computeLayouts)), "Unable to allocate particle compute sets");
+    std::ranges::copy(sets, m_ComputeSets.begin());
+    VK_CHECK_AND_SET(sets, m_Device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo(m_DescriptorPool, drawLayouts)), "Unable to allocate particle draw sets");
+    std::ranges::copy(sets, m_DrawSets.begin());
+
+    for (uint32_t destination = 0; destination < STATE_COUNT; destination++)
+    {
+        uint32_t source = (destination + 1) % STATE_COUNT;
+        std::array<vk::DescriptorBufferInfo, 4> computeInfos = {
+            vk::DescriptorBufferInfo(m_ParticleBuffers[source], 0, vk::WholeSize),
+            vk::DescriptorBufferInfo(m_ParticleBuffers[destination], 0, vk::WholeSize),
+            vk::DescriptorBufferInfo(m_CounterBuffers[source], 0, vk::WholeSize),
+            vk::DescriptorBufferInfo(m_CounterBuffers[destination], 0, vk::WholeSize)
+        };
+        vk::DescriptorBufferInfo drawInfo(m_ParticleBuffers[destination], 0, vk::WholeSize);
+
+        std::array<vk::WriteDescriptorSet, 2> writes = {
+            vk::WriteDescriptorSet(m_ComputeSets[destination], 0, 0, vk::DescriptorType::eStorageBuffer, nullptr, computeInfos),
+            vk::WriteDescriptorSet(m_DrawSets[destination], 0, 0, vk::DescriptorType::eStorageBuffer, nullptr, drawInfo)
+        };
+        m_Device.updateDescriptorSets(writes, nullptr);
+    }
+}
+
+void ParticleSystem::CreateComputePipelines()
+{
+    vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(ParticlePushConstants));
+    VK_CHECK_AND_SET(m_ComputeLayout, m_Device.createPipelineLayout(vk::PipelineLayoutCreateInfo({ }, m_ComputeSetLayout, pushConstantRange)), "Unable to create particle compute layout");
+
+    auto createComputePipeline = [this](const std::string &path) {
+        vk::ShaderModule shader = CreateShaderModule(m_Device, path);
+        vk::ComputePipelineCreateInfo pipelineCI({ }, vk::PipelineShaderStageCreateInfo({ }, vk::ShaderStageFlagBits::eCompute, shader, "main"), m_ComputeLayout);
+        auto pipelineResult = m_Device.createComputePipeline(nullptr, pipelineCI);
+        m_Device.destroyShaderModule(shader);
+        if (pipelineResult.result != vk::Result::eSuccess)
+            throw std::runtime_error("Unable to create particle compute pipeline!");
+        return pipelineResult.value;
+    };
+
+    m_SimulatePipeline = createComputePipeline("res/particle_simulate.comp.spv");
+    m_EmitPipeline = createComputePipeline("res/particle_emit.comp.spv");
+    m_FinalizePipeline = createComputePipeline("res/particle_finalize.comp.spv");
+}
+
+void ParticleSystem::CreatePipeline(vk::Format colorFormat, const vk::Viewport &viewport, const vk::Rect2D &scissor)
+{
+    vk::ShaderModule vertexShader = CreateShaderModule(m_Device, "res/particle.vert.spv");
+    vk::ShaderModule fragmentShader = CreateShaderModule(m_Device, "res/particle.frag.spv");
+
+    std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStageCreateInfos = {
+        vk::PipelineShaderStageCreateInfo({ }, vk::ShaderStageFlagBits::eVertex, vertexShader, "main"),
+        vk::PipelineShaderStageCreateInfo({ }, vk::ShaderStageFlagBits::eFragment, fragmentShader, "main")
+    };
+
+    // Particles are pulled from the storage buffer, one point per particle
+    vk::PipelineVertexInputStateCreateInfo vertexInputCreateInfo({}, nullptr, nullptr);
+    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyCreateInfo({}, vk::PrimitiveTopology::ePointList, vk::False);
+    vk::PipelineViewportStateCreateInfo viewportStateCreateInfo({}, viewport, scissor);
+    vk::PipelineRasterizationStateCreateInfo rasterizationStateCreateInfo({}, vk::False, vk::False, vk::PolygonMode::eFill, vk::CullModeFlagBits::eNone, vk::FrontFace::eCounterClockwise, vk::False, 0, 0, 0, 1.0);
+    vk::PipelineMultisampleStateCreateInfo multisampleStateCreateInfo({}, vk::SampleCountFlagBits::e1, vk::False);
+
+    // Additive blending so overlapping particles don't need sorting
+    vk::PipelineColorBlendAttachmentState colorBlendAttachmentState(vk::True, vk::BlendFactor::eSrcAlpha, vk::BlendFactor::eOne, vk::BlendOp::eAdd, vk::BlendFactor::eOne, vk::BlendFactor::eZero, vk::BlendOp::eAdd, vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
+    vk::PipelineColorBlendStateCreateInfo colorBlendCreateInfo({}, vk::False, vk::LogicOp::eCopy, colorBlendAttachmentState, {1.0f, 1.0f, 1.0f, 1.0f});
+
+    VK_CHECK_AND_SET(m_DrawLayout, m_Device.createPipelineLayout(vk::PipelineLayoutCreateInfo({ }, m_DrawSetLayout, nullptr)), "Unable to create particle draw layout");
+
+    vk::PipelineRenderingCreateInfo renderingCreateInfo(0, colorFormat);
+    vk::GraphicsPipelineCreateInfo pipelineCreateInfo({}, shaderStageCreateInfos, &vertexInputCreateInfo, &inputAssemblyCreateInfo, nullptr, &viewportStateCreateInfo, &rasterizationStateCreateInfo, &multisampleStateCreateInfo, nullptr, &colorBlendCreateInfo, nullptr, m_DrawLayout);
+    vk::StructureChain<vk::GraphicsPipelineCreateInfo, vk::PipelineRenderingCreateInfo> pipelineChain(pipelineCreateInfo, renderingCreateInfo);
+
+    auto pipelineResult = m_Device.createGraphicsPipeline(nullptr, pipelineChain.get<vk::GraphicsPipelineCreateInfo>());
+    m_Device.destroyShaderModule(vertexShader);
+    m_Device.destroyShaderModule(fragmentShader);
+    if (pipelineResult.result != vk::Result::eSuccess)
+        throw std::runtime_error("Unable to create particle draw pipeline!");
+    m_DrawPipeline = pipelineResult.value;
+}
+
+void ParticleSystem::DestroyPipeline()
+{
+    m_Device.destroyPipeline(m_DrawPipeline);
+    m_Device.destroyPipelineLayout(m_DrawLayout);
+    m_DrawPipeline = nullptr;
+    m_DrawLayout = nullptr;
+}
+
+void ParticleSystem::ClearState(vk::Queue computeQueue)
+{
+    // Zeroed counters describe an empty state with an empty dispatch and draw
+    vk::CommandBuffer commandBuffer = m_CommandBuffers[0];
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    for (const auto &counterBuffer : m_CounterBuffers)
+        commandBuffer.fillBuffer(counterBuffer, 0, vk::WholeSize, 0);
+    commandBuffer.end();
+
+    vk::CommandBufferSubmitInfo commandBufferSubmitInfo(commandBuffer);
+    computeQueue.submit2(vk::SubmitInfo2({ }, nullptr, commandBufferSubmitInfo, nullptr));
+    computeQueue.waitIdle();
+}
+
+void ParticleSystem::Draw(vk::CommandBuffer commandBuffer)
+{
+    m_DrawStep = m_Step;
+    uint32_t state = m_DrawStep % STATE_COUNT;
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, m_DrawPipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, m_DrawLayout, 0, m_DrawSets[state], nullptr);
+    commandBuffer.drawIndirect(m_CounterBuffers[state], offsetof(ParticleCounters, draw), 1, sizeof(vk::DrawIndirectCommand));
+}
+
+void ParticleSystem::Simulate(vk::Queue computeQueue, float deltaTime)
+{
+    uint64_t step = m_Step + 1;
+    uint32_t source = m_Step % STATE_COUNT;
+    uint32_t destination = step % STATE_COUNT;
+
+    // The command buffer for this state was last used two steps ago
+    if (step > STATE_COUNT)
+    {
+        uint64_t previousUse = step - STATE_COUNT;
+        while (m_Device.waitSemaphores(vk::SemaphoreWaitInfo({ }, m_ComputeTimeline, previousUse), UINT64_MAX) == vk::Result::eTimeout) { }
+    }
+
+    // Emit enough to keep the pool full on average, the emit shader drops anything past capacity
+    m_EmitAccumulator += deltaTime * static_cast<float>(m_Capacity) / AVERAGE_LIFETIME;
+    uint32_t emitCount = static_cast<uint32_t>(std::min(m_EmitAccumulator, static_cast<float>(m_Capacity)));
+    m_EmitAccumulator = std::min(m_EmitAccumulator - static_cast<float>(emitCount), 1.0f);
+
+    ParticlePushConstants pushConstants = { deltaTime, emitCount, static_cast<uint32_t>(step * 0x9E3779B9u), m_Capacity };
+
+    vk::CommandBuffer commandBuffer = m_CommandBuffers[destination];
+    commandBuffer.reset();
+    commandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    RecordSimulation(commandBuffer, source, destination, pushConstants);
+    commandBuffer.end();
+
+    // Overwriting the destination state has to wait for the draw that last read it
+    vk::SemaphoreSubmitInfo waitSemaphoreSubmitInfo(m_GraphicsTimeline, step - 1, vk::PipelineStageFlagBits2::eAllCommands);
+    vk::SemaphoreSubmitInfo signalSemaphoreSubmitInfo(m_ComputeTimeline, step, vk::PipelineStageFlagBits2::eAllCommands);
+    vk::CommandBufferSubmitInfo commandBufferSubmitInfo(commandBuffer);
+    computeQueue.submit2(vk::SubmitInfo2({ }, waitSemaphoreSubmitInfo, commandBufferSubmitInfo, signalSemaphoreSubmitInfo));
+
+    m_Step = step;
+}
+
+void ParticleSystem::RecordSimulation(vk::CommandBuffer commandBuffer, uint32_t source, uint32_t destination, const ParticlePushConstants &pushConstants)
+{
+    auto computeBarrier = [&commandBuffer](vk::PipelineStageFlags2 srcStage, vk::AccessFlags2 srcAccess) {
+        vk::MemoryBarrier2 barrier(
+                srcStage,
+                srcAccess,
+                vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eDrawIndirect,
+                vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eIndirectCommandRead);
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo({ }, barrier, nullptr, nullptr));
+    };
+
+    // Make the previous step's results visible to this step's indirect dispatch
+    computeBarrier(vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite);
+
+    commandBuffer.fillBuffer(m_CounterBuffers[destination], 0, vk::WholeSize, 0);
+    computeBarrier(vk::PipelineStageFlagBits2::eClear, vk::AccessFlagBits2::eTransferWrite);
+
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_ComputeLayout, 0, m_ComputeSets[destination], nullptr);
+    commandBuffer.pushConstants<ParticlePushConstants>(m_ComputeLayout, vk::ShaderStageFlagBits::eCompute, 0, pushConstants);
+
+    // Integrate the alive particles and compact the survivors, sized by the previous finalize pass
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_SimulatePipeline);
+    commandBuffer.dispatchIndirect(m_CounterBuffers[source], offsetof(ParticleCounters, dispatch));
+    computeBarrier(vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite);
+
+    // Append new particles after the survivors
+    if (pushConstants.emitCount > 0)
+    {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_EmitPipeline);
+        commandBuffer.dispatch((pushConstants.emitCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        computeBarrier(vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite);
+    }
+
+    // Clamp the count and write the indirect arguments for the next step and the draw
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_FinalizePipeline);
+    commandBuffer.dispatch(1, 1, 1);
+}
+
+vk::SemaphoreSubmitInfo ParticleSystem::GetDrawWaitInfo() const
+{
+    return vk::SemaphoreSubmitInfo(m_ComputeTimeline, m_DrawStep, vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eVertexShader);
+}
+
+vk::SemaphoreSubmitInfo ParticleSystem::GetDrawSignalInfo() const
+{
+    return vk::SemaphoreSubmitInfo(m_GraphicsTimeline, m_DrawStep + 1, vk::PipelineStageFlagBits2::eAllCommands);
+}
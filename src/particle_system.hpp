@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+
+#include <array>
+#include <cstdint>
+
+// Matches Particle in res/particle_common.glsl
+struct Particle
+{
+    float positionAge[4];
+    float velocityLifetime[4];
+};
+
+// Matches ParticleCounters in res/particle_common.glsl. The alive count is
+// followed by the arguments for the next simulation dispatch and for the draw,
+// so the GPU drives both without the CPU reading anything back.
+struct ParticleCounters
+{
+    uint32_t aliveCount;
+    vk::DispatchIndirectCommand dispatch;
+    vk::DrawIndirectCommand draw;
+};
+
+// Matches SimulationParams in res/particle_common.glsl
+struct ParticlePushConstants
+{
+    float deltaTime;
+    uint32_t emitCount;
+    uint32_t seed;
+    uint32_t capacity;
+};
+
+// Particles simulated entirely on the compute queue. Each step reads one state
+// buffer and compacts the survivors and new particles into the other, so the
+// graphics queue draws the previous step while the next one is simulated.
+// Timeline semaphores order the two queues.
+class ParticleSystem {
+public:
+    void Create(vk::PhysicalDevice physicalDevice, vk::Device device, vk::Queue computeQueue, uint32_t graphicsIndex, uint32_t computeIndex, uint32_t capacity);
+    void Destroy();
+
+    void CreatePipeline(vk::Format colorFormat, const vk::Viewport &viewport, const vk::Rect2D &scissor);
+    void DestroyPipeline();
+
+    // Records a draw of the latest submitted step. Call before Simulate.
+    void Draw(vk::CommandBuffer commandBuffer);
+    // Submits the next simulation step to the compute queue
+    void Simulate(vk::Queue computeQueue, float deltaTime);
+
+    // Semaphores the graphics submission that contains Draw must wait on and signal
+    vk::SemaphoreSubmitInfo GetDrawWaitInfo() const;
+    vk::SemaphoreSubmitInfo GetDrawSignalInfo() const;
+
+    uint32_t GetCapacity() const { return m_Capacity; }
+
+private:
+    void CreateBuffers(uint32_t graphicsIndex, uint32_t computeIndex);
+    void CreateDescriptors();
+    void CreateComputePipelines();
+    void ClearState(vk::Queue computeQueue);
+    void RecordSimulation(vk::CommandBuffer commandBuffer, uint32_t source, uint32_t destination, const ParticlePushConstants &pushConstants);
+
+private:
+    static constexpr uint32_t STATE_COUNT = 2;
+
+    vk::PhysicalDevice m_PhysicalDevice;
+    vk::Device m_Device;
+    uint32_t m_Capacity = 0;
+
+    std::array<vk::Buffer, STATE_COUNT> m_ParticleBuffers;
+    std::array<vk::DeviceMemory, STATE_COUNT> m_ParticleMemory;
+    std::array<vk::Buffer, STATE_COUNT> m_CounterBuffers;
+    std::array<vk::DeviceMemory, STATE_COUNT> m_CounterMemory;
+
+    vk::DescriptorPool m_DescriptorPool;
+    vk::DescriptorSetLayout m_ComputeSetLayout;
+    vk::DescriptorSetLayout m_DrawSetLayout;
+    // Indexed by the state being written for compute and the state being read for drawing
+    std::array<vk::DescriptorSet, STATE_COUNT> m_ComputeSets;
+    std::array<vk::DescriptorSet, STATE_COUNT> m_DrawSets;
+
+    vk::PipelineLayout m_ComputeLayout;
+    vk::Pipeline m_SimulatePipeline;
+    vk::Pipeline m_EmitPipeline;
+    vk::Pipeline m_FinalizePipeline;
+
+    vk::PipelineLayout m_DrawLayout;
+    vk::Pipeline m_DrawPipeline;
+
+    vk::CommandPool m_CommandPool;
+    std::array<vk::CommandBuffer, STATE_COUNT> m_CommandBuffers;
+
+    // Step N is complete on the compute queue when m_ComputeTimeline reaches N,
+    // and the draw of step N is complete when m_GraphicsTimeline reaches N + 1
+    vk::Semaphore m_ComputeTimeline;
+    vk::Semaphore m_GraphicsTimeline;
+    uint64_t m_Step = 0;
+    uint64_t m_DrawStep = 0;
+
+    float m_EmitAccumulator = 0.0f;
+};
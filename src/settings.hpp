@@ -1,11 +1,83 @@
 #pragma once
 
+#include "vulkan/vulkan.hpp"
+
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <print>
 
 struct Settings {
     uint32_t width, height;
+    // Preferred present mode, falls back to FIFO when the surface lacks it
+    vk::PresentModeKHR presentMode;
+    // Requested swapchain image count, clamped to the surface capabilities
+    uint32_t swapchainImages;
+    bool framePacing;
+    // Capacity of the GPU particle system, 0 disables it
+    uint32_t particleCount;
+    // Sphere grid drawn with vertex pulling, 0 disables it
+    uint32_t meshGridSize;
+    bool quantizedVertices;
+    // Frames to time with each vertex format before exiting, 0 runs normally
+    uint32_t benchmarkFrames;
+
+    Settings(): width(600), height(800), presentMode(vk::PresentModeKHR::eMailbox), swapchainImages(2), framePacing(true), particleCount(1 << 20),
+                meshGridSize(4), quantizedVertices(true), benchmarkFrames(0) { }
+
+    Settings(uint32_t _width, uint32_t _height): Settings() { width = _width; height = _height; }
 
-    Settings(): width(600), height(800) { }
+    // Usage: Blossom [--present-mode fifo|fifo-relaxed|mailbox|immediate] [--images N] [--no-pacing] [--particles N]
+    //                [--mesh-grid N] [--vertex-format float|quantized] [--benchmark-vertices FRAMES]
+    static Settings FromArgs(int argc, char **argv)
+    {
+        Settings settings;
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--present-mode") == 0 && i + 1 < argc)
+            {
+                const char *mode = argv[++i];
+                if (strcmp(mode, "fifo") == 0)
+                    settings.presentMode = vk::PresentModeKHR::eFifo;
+                else if (strcmp(mode, "fifo-relaxed") == 0)
+                    settings.presentMode = vk::PresentModeKHR::eFifoRelaxed;
+                else if (strcmp(mode, "mailbox") == 0)
+                    settings.presentMode = vk::PresentModeKHR::eMailbox;
+                else if (strcmp(mode, "immediate") == 0)
+                    settings.presentMode = vk::PresentModeKHR::eImmediate;
+                else
+                    std::print("Unknown present mode: {}\n", mode);
+            }
+            else if (strcmp(argv[i], "--images") == 0 && i + 1 < argc)
+                settings.swapchainImages = static_cast<uint32_t>(atoi(argv[++i]));
+            else if (strcmp(argv[i], "--no-pacing") == 0)
+                settings.framePacing = false;
+            else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc)
+                settings.particleCount = static_cast<uint32_t>(atoi(argv[++i]));
+            else if (strcmp(argv[i], "--mesh-grid") == 0 && i + 1 < argc)
+                settings.meshGridSize = static_cast<uint32_t>(atoi(argv[++i]));
+            else if (strcmp(argv[i], "--vertex-format") == 0 && i + 1 < argc)
+            {
+                const char *format = argv[++i];
+                if (strcmp(format, "float") == 0)
+                    settings.quantizedVertices = false;
+                else if (strcmp(format, "quantized") == 0)
+                    settings.quantizedVertices = true;
+                else
+                    std::print("Unknown vertex format: {}\n", format);
+            }
+            else if (strcmp(argv[i], "--benchmark-vertices") == 0 && i + 1 < argc)
+                settings.benchmarkFrames = static_cast<uint32_t>(atoi(argv[++i]));
+            else
+                std::print("Unknown argument: {}\n", argv[i]);
+        }
 
-    Settings(uint32_t _width, uint32_t _height): width(_width), height(_height) { }
+        // The vertex benchmark times the mesh draw alone, so nothing may overlap or throttle it
+        if (settings.benchmarkFrames > 0)
+        {
+            settings.particleCount = 0;
+            settings.framePacing = false;
+        }
+        return settings;
+    }
 };
@@ -0,0 +1,53 @@
+#include "simulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <thread>
+
+constexpr float MOVE_SPEED = 1.0f;
+constexpr float SPIN_SPEED = std::numbers::pi_v<float> / 2.0f;
+// Drop ticks instead of spiralling when the thread falls far behind
+constexpr int MAX_CATCH_UP_TICKS = 8;
+
+void Simulation::Run(std::stop_token stopToken, TripleBuffer<InputState> &inputBuffer)
+{
+    auto timestep = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(TIMESTEP));
+    auto nextTick = Clock::now();
+
+    m_Snapshots.Publish(m_State);
+
+    while (!stopToken.stop_requested())
+    {
+        std::this_thread::sleep_until(nextTick);
+
+        inputBuffer.Update();
+        const InputState &input = inputBuffer.Front();
+
+        int ticks = 0;
+        auto now = Clock::now();
+        while (nextTick <= now && ticks < MAX_CATCH_UP_TICKS)
+        {
+            Step(input);
+            nextTick += timestep;
+            ticks++;
+        }
+        if (nextTick <= now)
+            nextTick = now + timestep;
+
+        m_Snapshots.Publish(m_State);
+    }
+}
+
+void Simulation::Step(const InputState &input)
+{
+    float dt = static_cast<float>(TIMESTEP);
+
+    m_State.offset[0] += ((input.moveRight ? 1.0f : 0.0f) - (input.moveLeft ? 1.0f : 0.0f)) * MOVE_SPEED * dt;
+    m_State.offset[1] += ((input.moveDown ? 1.0f : 0.0f) - (input.moveUp ? 1.0f : 0.0f)) * MOVE_SPEED * dt;
+    m_State.offset[0] = std::clamp(m_State.offset[0], -1.0f, 1.0f);
+    m_State.offset[1] = std::clamp(m_State.offset[1], -1.0f, 1.0f);
+
+    m_State.angle = std::fmod(m_State.angle + SPIN_SPEED * dt, 2.0f * std::numbers::pi_v<float>);
+    m_State.tick++;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "triple_buffer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <stop_token>
+
+// Input as sampled on the main thread
+struct InputState {
+    bool moveLeft = false;
+    bool moveRight = false;
+    bool moveUp = false;
+    bool moveDown = false;
+};
+
+// Immutable view of the simulation handed to the render thread
+struct FrameSnapshot {
+    uint64_t tick = 0;
+    float offset[2] = { 0.0f, 0.0f };
+    float angle = 0.0f;
+};
+
+// Runs the scene at a fixed timestep on its own thread. Input is read from and
+// snapshots are published to triple buffers, so a slow frame on either side
+// never stalls the simulation.
+class Simulation {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double TIMESTEP = 1.0 / 120.0;
+
+    void Run(std::stop_token stopToken, TripleBuffer<InputState> &inputBuffer);
+
+    TripleBuffer<FrameSnapshot> &GetSnapshots() { return m_Snapshots; }
+
+private:
+    void Step(const InputState &input);
+
+private:
+    FrameSnapshot m_State;
+    TripleBuffer<FrameSnapshot> m_Snapshots;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer, single consumer handoff. The writer always has a
+// slot of its own to fill and the reader always keeps the last published value,
+// so neither side ever waits on the other. Published values are immutable to
+// the reader until it asks for a newer one.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side: copy a complete value into the back slot and publish it
+    void Publish(const T &value)
+    {
+        m_Slots[m_Back].value = value;
+        m_Back = m_Middle.exchange(m_Back | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side: swap in the newest published value, returns false if nothing new was published
+    bool Update()
+    {
+        if (!(m_Middle.load(std::memory_order_relaxed) & DIRTY_BIT))
+            return false;
+        m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T &Front() const { return m_Slots[m_Front].value; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY_BIT = 0x4;
+
+    // Keep slots on separate cache lines so the two threads don't false share
+    struct alignas(64) Slot {
+        T value { };
+    };
+
+    std::array<Slot, 3> m_Slots;
+    alignas(64) std::atomic<uint8_t> m_Middle { 1 };
+    alignas(64) uint8_t m_Back = 0;
+    alignas(64) uint8_t m_Front = 2;
+};
@@ -1,6 +1,14 @@
 #pragma once
 
+#include "vulkan/vulkan.hpp"
+
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <print>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #define VK_CHECK_AND_SET(var, result, message) \
     try { \
@@ -12,16 +20,75 @@
         exit(1); \
     }
 
-uint32_t Clamp(uint32_t value, uint32_t min, uint32_t max)
+inline uint32_t Clamp(uint32_t value, uint32_t min, uint32_t max)
 {
     if (value < min) return min;
     else if (value > max) return max;
     return max;
 }
 
-int32_t Clamp(int32_t value, int32_t min, int32_t max)
+inline int32_t Clamp(int32_t value, int32_t min, int32_t max)
 {
     if (value < min) return min;
     else if (value > max) return max;
     return max;
 }
+
+inline std::vector<uint32_t> LoadShader(const std::string &path)
+{
+    std::ifstream shaderStream(path, std::ios::ate | std::ios::binary);
+    if (!shaderStream.is_open())
+    {
+        std::print("Unable to open file: {}\n", path);
+        exit(1);
+    }
+
+    size_t fileSize = (size_t) shaderStream.tellg();
+    shaderStream.seekg(0);
+
+    std::vector<uint32_t> shaderCode(fileSize / sizeof(uint32_t));
+
+    shaderStream.read(reinterpret_cast<char *>(shaderCode.data()), fileSize);
+    shaderStream.close();
+
+    return shaderCode;
+}
+
+inline vk::ShaderModule CreateShaderModule(vk::Device device, const std::string &path)
+{
+    std::vector<uint32_t> shaderCode = LoadShader(path);
+    vk::ShaderModule shaderModule;
+    VK_CHECK_AND_SET(shaderModule, device.createShaderModule(vk::ShaderModuleCreateInfo({ }, shaderCode.size() * sizeof(uint32_t), shaderCode.data())), "Unable to create shader module");
+    return shaderModule;
+}
+
+inline uint32_t FindMemoryType(vk::PhysicalDevice physicalDevice, uint32_t typeBits, vk::MemoryPropertyFlags properties)
+{
+    vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeBits & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            return i;
+    }
+    throw std::runtime_error("Unable to find a suitable memory type!");
+}
+
+// Creates a buffer backed by its own allocation. Passing more than one queue
+// family shares the buffer concurrently between them.
+inline void CreateBuffer(vk::PhysicalDevice physicalDevice, vk::Device device, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer &buffer, vk::DeviceMemory &memory, const std::vector<uint32_t> &queueFamilies = { })
+{
+    bool concurrent = queueFamilies.size() > 1;
+    vk::BufferCreateInfo bufferCI(
+            { },
+            size,
+            usage,
+            concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+            concurrent ? static_cast<uint32_t>(queueFamilies.size()) : 0,
+            concurrent ? queueFamilies.data() : nullptr);
+    VK_CHECK_AND_SET(buffer, device.createBuffer(bufferCI), "Unable to create buffer");
+
+    vk::MemoryRequirements requirements = device.getBufferMemoryRequirements(buffer);
+    vk::MemoryAllocateInfo allocateInfo(requirements.size, FindMemoryType(physicalDevice, requirements.memoryTypeBits, properties));
+    VK_CHECK_AND_SET(memory, device.allocateMemory(allocateInfo), "Unable to allocate buffer memory");
+    device.bindBufferMemory(buffer, memory, 0);
+}
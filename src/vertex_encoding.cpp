@@ -0,0 +1,123 @@
+#include "vertex_encoding.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+static uint32_t PackUnorm16(float value)
+{
+    return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+static uint32_t PackSnorm16(float value)
+{
+    return static_cast<uint16_t>(static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f)));
+}
+
+MeshBounds ComputeBounds(const std::vector<Vertex> &vertices)
+{
+    MeshBounds bounds = { };
+    float max[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        bounds.min[axis] = std::numeric_limits<float>::max();
+        max[axis] = std::numeric_limits<float>::lowest();
+    }
+
+    for (const auto &vertex : vertices)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            bounds.min[axis] = std::min(bounds.min[axis], vertex.position[axis]);
+            max[axis] = std::max(max[axis], vertex.position[axis]);
+        }
+    }
+
+    // Flat meshes still need a non-zero extent to divide by
+    for (int axis = 0; axis < 3; axis++)
+        bounds.extent[axis] = vertices.empty() ? 1.0f : std::max(max[axis] - bounds.min[axis], std::numeric_limits<float>::epsilon());
+
+    return bounds;
+}
+
+QuantizedVertex QuantizeVertex(const Vertex &vertex, const MeshBounds &bounds)
+{
+    uint32_t position[3];
+    for (int axis = 0; axis < 3; axis++)
+        position[axis] = PackUnorm16((vertex.position[axis] - bounds.min[axis]) / bounds.extent[axis]);
+
+    QuantizedVertex quantized;
+    quantized.positionXY = position[0] | (position[1] << 16);
+    quantized.positionZ = position[2] | (vertex.tangent[3] < 0.0f ? 1u << 16 : 0u);
+    quantized.normal = EncodeOctahedral(vertex.normal);
+    quantized.tangent = EncodeOctahedral(vertex.tangent);
+    quantized.uv = FloatToHalf(vertex.uv[0]) | (static_cast<uint32_t>(FloatToHalf(vertex.uv[1])) << 16);
+    return quantized;
+}
+
+std::vector<QuantizedVertex> QuantizeVertices(const std::vector<Vertex> &vertices, const MeshBounds &bounds)
+{
+    std::vector<QuantizedVertex> quantized;
+    quantized.reserve(vertices.size());
+    for (const auto &vertex : vertices)
+        quantized.push_back(QuantizeVertex(vertex, bounds));
+    return quantized;
+}
+
+uint32_t EncodeOctahedral(const float direction[3])
+{
+    float length = std::abs(direction[0]) + std::abs(direction[1]) + std::abs(direction[2]);
+    if (length == 0.0f)
+        return 0;
+
+    float x = direction[0] / length;
+    float y = direction[1] / length;
+    // Fold the lower hemisphere over the diagonals
+    if (direction[2] < 0.0f)
+    {
+        float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return PackSnorm16(x) | (PackSnorm16(y) << 16);
+}
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    // NaN and infinity
+    if (((bits >> 23) & 0xFF) == 0xFF)
+        return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    // Too large, clamp to infinity
+    if (exponent >= 31)
+        return static_cast<uint16_t>(sign | 0x7C00);
+    // Too small for a normal half, shift into a denormal or flush to zero
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        // Round to nearest even
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    // Round to nearest even, a carry into the exponent is still correct
+    uint32_t remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        half++;
+    return static_cast<uint16_t>(half);
+}
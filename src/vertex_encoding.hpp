@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Full precision vertex, matches the layout read by res/mesh_float.vert
+struct Vertex
+{
+    float position[3];
+    float normal[3];
+    float tangent[4];   // xyz direction, w bitangent sign
+    float uv[2];
+};
+
+// Compact vertex read by res/mesh_quantized.vert:
+// - positions as 16-bit unorms relative to the mesh bounds
+// - normals and tangents octahedral encoded as two 16-bit snorms
+// - uvs as two half floats
+struct QuantizedVertex
+{
+    uint32_t positionXY;
+    uint32_t positionZ;     // low 16 bits position, bit 16 set for a negative bitangent sign
+    uint32_t normal;
+    uint32_t tangent;
+    uint32_t uv;
+};
+
+static_assert(sizeof(Vertex) == 48);
+static_assert(sizeof(QuantizedVertex) == 20);
+
+struct MeshBounds
+{
+    float min[3];
+    float extent[3];
+};
+
+MeshBounds ComputeBounds(const std::vector<Vertex> &vertices);
+
+QuantizedVertex QuantizeVertex(const Vertex &vertex, const MeshBounds &bounds);
+std::vector<QuantizedVertex> QuantizeVertices(const std::vector<Vertex> &vertices, const MeshBounds &bounds);
+
+// Maps a unit vector onto the octahedron and packs it as two 16-bit snorms
+uint32_t EncodeOctahedral(const float direction[3]);
+uint16_t FloatToHalf(float value);
@@ -0,0 +1,120 @@
+#include "image_compare.hpp"
+
+#include <fstream>
+
+// Largest possible YIQ delta, between black and white
+constexpr double MAX_YIQ_DELTA = 35215.0;
+
+bool ReadPPM(const std::string &path, Image &image)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    std::string magic;
+    uint32_t maxValue = 0;
+    file >> magic >> image.width >> image.height >> maxValue;
+    if (!file || magic != "P6" || maxValue != 255)
+        return false;
+    // Exactly one whitespace character separates the header from the pixels
+    file.get();
+
+    image.pixels.resize(static_cast<size_t>(image.width) * image.height * 3);
+    file.read(reinterpret_cast<char *>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size()));
+    return static_cast<bool>(file);
+}
+
+bool WritePPM(const std::string &path, const Image &image)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    file << "P6\n" << image.width << " " << image.height << "\n255\n";
+    file.write(reinterpret_cast<const char *>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size()));
+    return static_cast<bool>(file);
+}
+
+Image ImageFromPixels(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t pixelStride)
+{
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+    {
+        image.pixels[i * 3 + 0] = pixels[i * pixelStride + 0];
+        image.pixels[i * 3 + 1] = pixels[i * pixelStride + 1];
+        image.pixels[i * 3 + 2] = pixels[i * pixelStride + 2];
+    }
+    return image;
+}
+
+static double Luma(double r, double g, double b)
+{
+    return r * 0.29889531 + g * 0.58662247 + b * 0.11448223;
+}
+
+// Squared YIQ distance weighted for perceived brightness and color
+static double ColorDelta(const uint8_t *a, const uint8_t *b)
+{
+    double y = Luma(a[0], a[1], a[2]) - Luma(b[0], b[1], b[2]);
+    double i = (a[0] * 0.59597799 - a[1] * 0.27417610 - a[2] * 0.32180189) - (b[0] * 0.59597799 - b[1] * 0.27417610 - b[2] * 0.32180189);
+    double q = (a[0] * 0.21147017 - a[1] * 0.52261711 + a[2] * 0.31114694) - (b[0] * 0.21147017 - b[1] * 0.52261711 + b[2] * 0.31114694);
+    return 0.5053 * y * y + 0.299 * i * i + 0.1957 * q * q;
+}
+
+static bool PixelDiffers(const uint8_t *golden, const uint8_t *actual, double threshold)
+{
+    return ColorDelta(golden, actual) > MAX_YIQ_DELTA * threshold * threshold;
+}
+
+CompareResult CompareImages(const Image &golden, const uint8_t *actual, uint32_t width, uint32_t height, uint32_t pixelStride, double threshold)
+{
+    CompareResult result;
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    if (golden.width != width || golden.height != height)
+    {
+        result.differingPixels = static_cast<uint32_t>(pixelCount);
+        result.differingFraction = 1.0;
+        return result;
+    }
+
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+        if (PixelDiffers(&golden.pixels[i * 3], &actual[i * pixelStride], threshold))
+            result.differingPixels++;
+    }
+
+    result.differingFraction = pixelCount > 0 ? static_cast<double>(result.differingPixels) / static_cast<double>(pixelCount) : 0.0;
+    return result;
+}
+
+Image DiffImage(const Image &golden, const uint8_t *actual, uint32_t pixelStride, double threshold)
+{
+    Image diff;
+    diff.width = golden.width;
+    diff.height = golden.height;
+    diff.pixels.resize(golden.pixels.size());
+
+    for (size_t i = 0; i < static_cast<size_t>(golden.width) * golden.height; i++)
+    {
+        const uint8_t *a = &golden.pixels[i * 3];
+        uint8_t *out = &diff.pixels[i * 3];
+
+        if (PixelDiffers(a, &actual[i * pixelStride], threshold))
+        {
+            out[0] = 255;
+            out[1] = 0;
+            out[2] = 0;
+            continue;
+        }
+
+        // Matching pixels are drawn as a faded grayscale of the golden for context
+        uint8_t gray = static_cast<uint8_t>(255.0 - (255.0 - Luma(a[0], a[1], a[2])) * 0.1);
+        out[0] = gray;
+        out[1] = gray;
+        out[2] = gray;
+    }
+    return diff;
+}
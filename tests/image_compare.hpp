@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Tightly packed RGB8 image, as stored in binary PPM files
+struct Image
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct CompareResult
+{
+    uint32_t differingPixels = 0;
+    double differingFraction = 0.0;
+};
+
+bool ReadPPM(const std::string &path, Image &image);
+bool WritePPM(const std::string &path, const Image &image);
+
+// Copies the RGB channels of 8 bit pixels that are pixelStride bytes apart, e.g. 4 for RGBA8
+Image ImageFromPixels(const uint8_t *pixels, uint32_t width, uint32_t height, uint32_t pixelStride);
+
+// Perceptual comparison in YIQ space, reading the actual pixels in place. A pixel
+// differs when its color delta exceeds the threshold, where 0 requires an exact
+// match and 1 accepts anything.
+CompareResult CompareImages(const Image &golden, const uint8_t *actual, uint32_t width, uint32_t height, uint32_t pixelStride, double threshold);
+
+// Faded grayscale of the golden with the pixels CompareImages counts as differing in red
+Image DiffImage(const Image &golden, const uint8_t *actual, uint32_t pixelStride, double threshold);
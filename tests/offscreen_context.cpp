@@ -0,0 +1,284 @@
+#include "offscreen_context.hpp"
+#include "utils.hpp"
+
+#include <chrono>
+#include <cstring>
+
+bool OffscreenContext::Create(uint32_t width, uint32_t height)
+{
+    m_Width = width;
+    m_Height = height;
+
+    // A machine without a loader or driver skips the tests rather than failing them
+    try
+    {
+        VULKAN_HPP_DEFAULT_DISPATCHER.init();
+    }
+    catch (const std::runtime_error &)
+    {
+        return false;
+    }
+
+    std::vector<const char *> layerNames;
+#ifndef NDEBUG
+    // Validate when the layer is installed, but don't require it on test machines
+    std::vector<vk::LayerProperties> layerProperties;
+    VK_CHECK_AND_SET(layerProperties, vk::enumerateInstanceLayerProperties(), "Unable to enumerate instance layer properties");
+    for (const auto &property : layerProperties)
+    {
+        if (strcmp(property.layerName, "VK_LAYER_KHRONOS_validation") == 0)
+            layerNames.push_back("VK_LAYER_KHRONOS_validation");
+    }
+#endif
+
+    vk::ApplicationInfo appInfo("Blossom Tests", 1, nullptr, 1, vk::ApiVersion13);
+    try
+    {
+        m_Instance = vk::createInstance(vk::InstanceCreateInfo({ }, &appInfo, layerNames, nullptr));
+    }
+    catch (const vk::SystemError &)
+    {
+        return false;
+    }
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(m_Instance);
+
+    if (!CreateDevice())
+        return false;
+
+    CreateTarget();
+    return true;
+}
+
+bool OffscreenContext::CreateDevice()
+{
+    std::vector<vk::PhysicalDevice> physicalDevices;
+    VK_CHECK_AND_SET(physicalDevices, m_Instance.enumeratePhysicalDevices(), "Unable to enumerate physical devices!");
+
+    // Take the first device with a queue that can both draw and dispatch. Point
+    // VK_DRIVER_FILES at a single driver, e.g. lavapipe, to pick one explicitly.
+    for (const auto &device : physicalDevices)
+    {
+        if (device.getProperties().apiVersion < vk::ApiVersion13)
+            continue;
+
+        auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>();
+        if (!features.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore ||
+            !features.get<vk::PhysicalDeviceVulkan13Features>().dynamicRendering ||
+            !features.get<vk::PhysicalDeviceVulkan13Features>().synchronization2)
+            continue;
+
+        std::vector<vk::QueueFamilyProperties> queueFamilyProperties = device.getQueueFamilyProperties();
+        for (uint32_t i = 0; i < queueFamilyProperties.size(); i++)
+        {
+            vk::QueueFlags required = vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute;
+            if ((queueFamilyProperties[i].queueFlags & required) == required)
+            {
+                m_PhysicalDevice = device;
+                m_QueueIndex = i;
+                break;
+            }
+        }
+        if (m_PhysicalDevice)
+            break;
+    }
+
+    if (!m_PhysicalDevice)
+        return false;
+
+    std::string deviceName(m_PhysicalDevice.getProperties().deviceName);
+    std::print("Rendering tests on {}\n", deviceName);
+
+    float priority = 0.0f;
+    vk::DeviceQueueCreateInfo queueCreateInfo({ }, m_QueueIndex, 1, &priority);
+
+    vk::PhysicalDeviceVulkan12Features vulkan12Features;
+    vulkan12Features.timelineSemaphore = vk::True;
+    vk::PhysicalDeviceVulkan13Features vulkan13Features;
+    vulkan13Features.dynamicRendering = vk::True;
+    vulkan13Features.synchronization2 = vk::True;
+
+    vk::StructureChain<vk::DeviceCreateInfo, vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features> deviceCreateChain = {
+        vk::DeviceCreateInfo({ }, queueCreateInfo, { }, { }),
+        vk::PhysicalDeviceFeatures2(),
+        vulkan12Features,
+        vulkan13Features
+    };
+
+    VK_CHECK_AND_SET(m_Device, m_PhysicalDevice.createDevice(deviceCreateChain.get<vk::DeviceCreateInfo>()), "Unable to create logical device!");
+    VULKAN_HPP_DEFAULT_DISPATCHER.init(m_Device);
+
+    m_Queue = m_Device.getQueue(m_QueueIndex, 0);
+    return true;
+}
+
+void OffscreenContext::CreateTarget()
+{
+    vk::ImageCreateInfo imageCI(
+            { },
+            vk::ImageType::e2D,
+            COLOR_FORMAT,
+            vk::Extent3D(m_Width, m_Height, 1),
+            1,
+            1,
+            vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc);
+    VK_CHECK_AND_SET(m_ColorImage, m_Device.createImage(imageCI), "Unable to create offscreen image");
+
+    vk::MemoryRequirements imageRequirements = m_Device.getImageMemoryRequirements(m_ColorImage);
+    vk::MemoryAllocateInfo imageAllocateInfo(imageRequirements.size, FindMemoryType(m_PhysicalDevice, imageRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    VK_CHECK_AND_SET(m_ColorMemory, m_Device.allocateMemory(imageAllocateInfo), "Unable to allocate offscreen image memory");
+    m_Device.bindImageMemory(m_ColorImage, m_ColorMemory, 0);
+
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+    VK_CHECK_AND_SET(m_ColorView, m_Device.createImageView(vk::ImageViewCreateInfo({ }, m_ColorImage, vk::ImageViewType::e2D, COLOR_FORMAT, { }, range)), "Unable to create offscreen image view");
+
+    // The readback buffer stays mapped for the lifetime of the context. Cached
+    // memory makes the CPU side comparison fast, coherent memory saves the invalidate.
+    vk::DeviceSize readbackSize = static_cast<vk::DeviceSize>(m_Width) * m_Height * 4;
+    VK_CHECK_AND_SET(m_ReadbackBuffer, m_Device.createBuffer(vk::BufferCreateInfo({ }, readbackSize, vk::BufferUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive)), "Unable to create readback buffer");
+    vk::MemoryRequirements bufferRequirements = m_Device.getBufferMemoryRequirements(m_ReadbackBuffer);
+
+    const vk::MemoryPropertyFlags preferredProperties[] = {
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached | vk::MemoryPropertyFlagBits::eHostCoherent,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+    };
+    vk::PhysicalDeviceMemoryProperties memoryProperties = m_PhysicalDevice.getMemoryProperties();
+    uint32_t memoryType = memoryProperties.memoryTypeCount;
+    for (const auto &properties : preferredProperties)
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && memoryType == memoryProperties.memoryTypeCount; i++)
+        {
+            if ((bufferRequirements.memoryTypeBits & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+                memoryType = i;
+        }
+    }
+    if (memoryType == memoryProperties.memoryTypeCount)
+        throw std::runtime_error("Unable to find host visible memory for readback!");
+    m_ReadbackCoherent = static_cast<bool>(memoryProperties.memoryTypes[memoryType].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+
+    VK_CHECK_AND_SET(m_ReadbackMemory, m_Device.allocateMemory(vk::MemoryAllocateInfo(bufferRequirements.size, memoryType)), "Unable to allocate readback memory");
+    m_Device.bindBufferMemory(m_ReadbackBuffer, m_ReadbackMemory, 0);
+    VK_CHECK_AND_SET(m_ReadbackMapped, m_Device.mapMemory(m_ReadbackMemory, 0, vk::WholeSize), "Unable to map readback memory");
+
+    VK_CHECK_AND_SET(m_CommandPool, m_Device.createCommandPool(vk::CommandPoolCreateInfo(vk::CommandPoolCreateFlagBits::eResetCommandBuffer, m_QueueIndex)), "Unable to create command pool");
+    VK_CHECK_AND_SET(m_CommandBuffer, m_Device.allocateCommandBuffers(vk::CommandBufferAllocateInfo(m_CommandPool, vk::CommandBufferLevel::ePrimary, 1)).front(), "Unable to allocate command buffers");
+    VK_CHECK_AND_SET(m_Fence, m_Device.createFence(vk::FenceCreateInfo()), "Unable to create fence");
+}
+
+void OffscreenContext::Destroy()
+{
+    if (m_Device)
+    {
+        m_Device.waitIdle();
+        m_Device.destroyFence(m_Fence);
+        m_Device.destroyCommandPool(m_CommandPool);
+        if (m_ReadbackMapped)
+            m_Device.unmapMemory(m_ReadbackMemory);
+        m_Device.destroyBuffer(m_ReadbackBuffer);
+        m_Device.freeMemory(m_ReadbackMemory);
+        m_Device.destroyImageView(m_ColorView);
+        m_Device.destroyImage(m_ColorImage);
+        m_Device.freeMemory(m_ColorMemory);
+        m_Device.destroy();
+    }
+    if (m_Instance)
+        m_Instance.destroy();
+}
+
+vk::Viewport OffscreenContext::GetViewport() const
+{
+    return vk::Viewport(0, 0, static_cast<float>(m_Width), static_cast<float>(m_Height), 0.0f, 1.0f);
+}
+
+vk::Rect2D OffscreenContext::GetScissor() const
+{
+    return vk::Rect2D({ 0, 0 }, { m_Width, m_Height });
+}
+
+double OffscreenContext::RenderFrame(const FrameHooks &hooks)
+{
+    vk::ImageSubresourceRange range(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+
+    m_CommandBuffer.reset();
+    m_CommandBuffer.begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+
+    if (hooks.beforeRendering)
+        hooks.beforeRendering(m_CommandBuffer);
+
+    vk::ImageMemoryBarrier2 renderBarrier(
+            vk::PipelineStageFlagBits2::eCopy,
+            vk::AccessFlagBits2::eTransferRead,
+            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            vk::AccessFlagBits2::eColorAttachmentWrite,
+            vk::ImageLayout::eUndefined,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::QueueFamilyIgnored,
+            vk::QueueFamilyIgnored,
+            m_ColorImage,
+            range);
+    m_CommandBuffer.pipelineBarrier2(vk::DependencyInfo({ }, nullptr, nullptr, renderBarrier));
+
+    vk::RenderingAttachmentInfo colorAttachmentInfo(
+            m_ColorView,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::ResolveModeFlagBits::eNone,
+            nullptr,
+            vk::ImageLayout::eUndefined,
+            vk::AttachmentLoadOp::eClear,
+            vk::AttachmentStoreOp::eStore,
+            vk::ClearValue({0.0f, 0.0f, 0.0f, 1.0f}));
+    m_CommandBuffer.beginRendering(vk::RenderingInfo({ }, GetScissor(), 1, 0, colorAttachmentInfo));
+    if (hooks.draw)
+        hooks.draw(m_CommandBuffer);
+    m_CommandBuffer.endRendering();
+
+    // Copy straight into the mapped buffer and make it visible to the host
+    vk::ImageMemoryBarrier2 copyBarrier(
+            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+            vk::AccessFlagBits2::eColorAttachmentWrite,
+            vk::PipelineStageFlagBits2::eCopy,
+            vk::AccessFlagBits2::eTransferRead,
+            vk::ImageLayout::eColorAttachmentOptimal,
+            vk::ImageLayout::eTransferSrcOptimal,
+            vk::QueueFamilyIgnored,
+            vk::QueueFamilyIgnored,
+            m_ColorImage,
+            range);
+    m_CommandBuffer.pipelineBarrier2(vk::DependencyInfo({ }, nullptr, nullptr, copyBarrier));
+
+    vk::BufferImageCopy region(0, 0, 0, vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1), { 0, 0, 0 }, { m_Width, m_Height, 1 });
+    m_CommandBuffer.copyImageToBuffer(m_ColorImage, vk::ImageLayout::eTransferSrcOptimal, m_ReadbackBuffer, region);
+
+    vk::BufferMemoryBarrier2 hostBarrier(
+            vk::PipelineStageFlagBits2::eCopy,
+            vk::AccessFlagBits2::eTransferWrite,
+            vk::PipelineStageFlagBits2::eHost,
+            vk::AccessFlagBits2::eHostRead,
+            vk::QueueFamilyIgnored,
+            vk::QueueFamilyIgnored,
+            m_ReadbackBuffer,
+            0,
+            vk::WholeSize);
+    m_CommandBuffer.pipelineBarrier2(vk::DependencyInfo({ }, nullptr, hostBarrier, nullptr));
+
+    m_CommandBuffer.end();
+
+    std::vector<vk::SemaphoreSubmitInfo> waitSemaphoreSubmitInfos;
+    std::vector<vk::SemaphoreSubmitInfo> signalSemaphoreSubmitInfos;
+    if (hooks.beforeSubmit)
+        hooks.beforeSubmit(waitSemaphoreSubmitInfos, signalSemaphoreSubmitInfos);
+
+    vk::CommandBufferSubmitInfo commandBufferSubmitInfo(m_CommandBuffer);
+    auto start = std::chrono::steady_clock::now();
+    m_Queue.submit2(vk::SubmitInfo2({ }, waitSemaphoreSubmitInfos, commandBufferSubmitInfo, signalSemaphoreSubmitInfos), m_Fence);
+    while (m_Device.waitForFences(m_Fence, vk::True, UINT64_MAX) == vk::Result::eTimeout) { }
+    auto end = std::chrono::steady_clock::now();
+    m_Device.resetFences(m_Fence);
+
+    if (!m_ReadbackCoherent)
+        m_Device.invalidateMappedMemoryRanges(vk::MappedMemoryRange(m_ReadbackMemory, 0, vk::WholeSize));
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
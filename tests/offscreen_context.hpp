@@ -0,0 +1,74 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// What a test scene records into a frame. Any hook may be left empty.
+struct FrameHooks
+{
+    // Recorded before rendering begins, e.g. query resets
+    std::function<void(vk::CommandBuffer)> beforeRendering;
+    // Recorded inside rendering to the offscreen target
+    std::function<void(vk::CommandBuffer)> draw;
+    // Called right before submission to add semaphores to the frame
+    std::function<void(std::vector<vk::SemaphoreSubmitInfo> &, std::vector<vk::SemaphoreSubmitInfo> &)> beforeSubmit;
+};
+
+// Headless Vulkan device rendering into an offscreen image. Every frame copies
+// the image straight into a persistently mapped host-visible buffer, so the
+// pixels can be compared in place without another copy.
+class OffscreenContext {
+public:
+    static constexpr vk::Format COLOR_FORMAT = vk::Format::eR8G8B8A8Unorm;
+    static constexpr uint32_t PIXEL_SIZE = 4;
+
+    // Returns false when no device supports what the renderer needs
+    bool Create(uint32_t width, uint32_t height);
+    void Destroy();
+
+    // Renders and reads back one frame, returns the wall time from submission to completion in ms
+    double RenderFrame(const FrameHooks &hooks);
+
+    // Tightly packed RGBA8 pixels of the last frame
+    const uint8_t *GetPixels() const { return static_cast<const uint8_t *>(m_ReadbackMapped); }
+
+    vk::PhysicalDevice GetPhysicalDevice() const { return m_PhysicalDevice; }
+    vk::Device GetDevice() const { return m_Device; }
+    vk::Queue GetQueue() const { return m_Queue; }
+    uint32_t GetQueueIndex() const { return m_QueueIndex; }
+    uint32_t GetWidth() const { return m_Width; }
+    uint32_t GetHeight() const { return m_Height; }
+    vk::Viewport GetViewport() const;
+    vk::Rect2D GetScissor() const;
+
+private:
+    bool CreateDevice();
+    void CreateTarget();
+
+private:
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+
+    vk::Instance m_Instance;
+    vk::PhysicalDevice m_PhysicalDevice;
+    vk::Device m_Device;
+    // Graphics and compute share one queue in tests
+    vk::Queue m_Queue;
+    uint32_t m_QueueIndex = 0;
+
+    vk::Image m_ColorImage;
+    vk::DeviceMemory m_ColorMemory;
+    vk::ImageView m_ColorView;
+
+    vk::Buffer m_ReadbackBuffer;
+    vk::DeviceMemory m_ReadbackMemory;
+    void *m_ReadbackMapped = nullptr;
+    bool m_ReadbackCoherent = true;
+
+    vk::CommandPool m_CommandPool;
+    vk::CommandBuffer m_CommandBuffer;
+    vk::Fence m_Fence;
+};
@@ -0,0 +1,346 @@
+#include "offscreen_context.hpp"
+#include "image_compare.hpp"
+#include "mesh_renderer.hpp"
+#include "particle_system.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <string>
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE;
+
+// Exit code CTest reports as skipped
+constexpr int SKIP_RETURN_CODE = 77;
+
+constexpr uint32_t TARGET_WIDTH = 256;
+constexpr uint32_t TARGET_HEIGHT = 256;
+// Frames rendered before timing starts, then frames timed. The golden is the last measured frame.
+constexpr uint32_t WARMUP_FRAMES = 8;
+constexpr uint32_t MEASURED_FRAMES = 32;
+// Particles step with a fixed delta so every run ends on the same simulation state
+constexpr float PARTICLE_DELTA_TIME = 1.0f / 60.0f;
+constexpr uint32_t PARTICLE_COUNT = 1 << 16;
+constexpr uint32_t MESH_GRID_SIZE = 2;
+
+// Frame times are checked against the median recorded on the reference device
+// (lavapipe) when the goldens were last updated, plus this margin for run to run noise.
+// BLOSSOM_FRAME_BUDGET_SCALE scales the budget further on other devices.
+constexpr double BUDGET_MARGIN = 1.25;
+// Allowed noise when one scene's draw must be at least as fast as another's, compared
+// with GPU timestamps from the same run. CPU rasterizers like lavapipe trade memory
+// bandwidth for ALU differently than GPUs, so there the ratio is only reported.
+constexpr double GPU_TIME_MARGIN = 1.10;
+
+struct Scene
+{
+    const char *name;
+    // Scenes that must look the same share a golden image, only the reference one writes it
+    const char *golden;
+    bool reference;
+    // Per pixel perceptual threshold and the fraction of pixels allowed past it
+    double threshold;
+    double maxDifferingFraction;
+    // Scene whose draw this one's must not be slower than, rendered in the same run
+    const char *notSlowerThan;
+};
+
+// Compacted particles land in a different order every run, so the particle scene
+// allows for the additive blend rounding differently where particles overlap.
+static const Scene SCENES[] = {
+    { "mesh_float", "mesh", true, 0.1, 0.001, nullptr },
+    { "mesh_quantized", "mesh", false, 0.1, 0.001, "mesh_float" },
+    { "particles", "particles", true, 0.2, 0.01, nullptr },
+};
+
+struct TestOptions
+{
+    std::string scene;
+    std::string goldenDirectory = "tests/golden";
+    std::string outputDirectory = ".";
+    bool updateGolden = false;
+
+    static TestOptions FromArgs(int argc, char **argv)
+    {
+        TestOptions options;
+        for (int i = 1; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+                options.scene = argv[++i];
+            else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+                options.goldenDirectory = argv[++i];
+            else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+                options.outputDirectory = argv[++i];
+            else if (strcmp(argv[i], "--update-golden") == 0)
+                options.updateGolden = true;
+            else
+                std::print("Unknown argument: {}\n", argv[i]);
+        }
+        return options;
+    }
+};
+
+static const Scene *FindScene(const std::string &name)
+{
+    for (const auto &scene : SCENES)
+    {
+        if (name == scene.name)
+            return &scene;
+    }
+    return nullptr;
+}
+
+static double GetBudgetScale()
+{
+    const char *scale = std::getenv("BLOSSOM_FRAME_BUDGET_SCALE");
+    if (!scale)
+        return 1.0;
+    double value = std::atof(scale);
+    return value > 0.0 ? value : 1.0;
+}
+
+// The median ignores the odd frame stalled by the OS
+static double Median(std::vector<double> frameTimes)
+{
+    std::sort(frameTimes.begin(), frameTimes.end());
+    return frameTimes[frameTimes.size() / 2];
+}
+
+static bool ReadBaseline(const std::string &path, double &medianFrameTime)
+{
+    std::ifstream file(path);
+    return static_cast<bool>(file >> medianFrameTime);
+}
+
+static bool WriteBaseline(const std::string &path, double medianFrameTime)
+{
+    std::ofstream file(path);
+    return static_cast<bool>(file << std::format("{:.3f}\n", medianFrameTime));
+}
+
+struct SceneTimings
+{
+    // Wall time from submission to readback
+    std::vector<double> frameTimes;
+    // GPU timestamps around the mesh draw, empty for other scenes or without timestamp support
+    std::vector<double> gpuTimes;
+};
+
+// Renders the scene and returns its timings, the last frame is left in the readback buffer
+static SceneTimings RenderScene(OffscreenContext &context, const Scene &scene)
+{
+    SceneTimings timings;
+    MeshRenderer meshRenderer;
+    ParticleSystem particleSystem;
+    FrameHooks hooks;
+
+    bool meshScene = strncmp(scene.name, "mesh", 4) == 0;
+    if (meshScene)
+    {
+        VertexFormat format = strcmp(scene.name, "mesh_quantized") == 0 ? VertexFormat::Quantized : VertexFormat::Float;
+        meshRenderer.Create(context.GetPhysicalDevice(), context.GetDevice(), context.GetQueue(), context.GetQueueIndex(), MESH_GRID_SIZE, format);
+        meshRenderer.CreatePipeline(OffscreenContext::COLOR_FORMAT, context.GetViewport(), context.GetScissor());
+
+        hooks.beforeRendering = [&meshRenderer](vk::CommandBuffer commandBuffer) { meshRenderer.BeginFrame(commandBuffer); };
+        hooks.draw = [&meshRenderer](vk::CommandBuffer commandBuffer) { meshRenderer.Draw(commandBuffer); };
+    }
+    else
+    {
+        // Graphics and compute share the context's queue
+        particleSystem.Create(context.GetPhysicalDevice(), context.GetDevice(), context.GetQueue(), context.GetQueueIndex(), context.GetQueueIndex(), PARTICLE_COUNT);
+        particleSystem.CreatePipeline(OffscreenContext::COLOR_FORMAT, context.GetViewport(), context.GetScissor());
+
+        hooks.draw = [&particleSystem](vk::CommandBuffer commandBuffer) { particleSystem.Draw(commandBuffer); };
+        hooks.beforeSubmit = [&particleSystem, &context](std::vector<vk::SemaphoreSubmitInfo> &waits, std::vector<vk::SemaphoreSubmitInfo> &signals) {
+            particleSystem.Simulate(context.GetQueue(), PARTICLE_DELTA_TIME);
+            waits.push_back(particleSystem.GetDrawWaitInfo());
+            signals.push_back(particleSystem.GetDrawSignalInfo());
+        };
+    }
+
+    for (uint32_t frame = 0; frame < WARMUP_FRAMES + MEASURED_FRAMES; frame++)
+    {
+        double frameTime = context.RenderFrame(hooks);
+        if (frame < WARMUP_FRAMES)
+            continue;
+
+        timings.frameTimes.push_back(frameTime);
+        if (meshScene)
+        {
+            meshRenderer.CollectTimings();
+            if (meshRenderer.GetLastGpuTime() > 0.0)
+                timings.gpuTimes.push_back(meshRenderer.GetLastGpuTime());
+        }
+    }
+
+    // The last simulation step may still be running
+    context.GetDevice().waitIdle();
+    if (meshScene)
+    {
+        meshRenderer.DestroyPipeline();
+        meshRenderer.Destroy();
+    }
+    else
+    {
+        particleSystem.DestroyPipeline();
+        particleSystem.Destroy();
+    }
+    return timings;
+}
+
+static int UpdateGolden(const OffscreenContext &context, const Scene &scene, const std::vector<double> &frameTimes, const TestOptions &options)
+{
+    std::filesystem::create_directories(options.goldenDirectory);
+
+    if (scene.reference)
+    {
+        std::string goldenPath = options.goldenDirectory + "/" + scene.golden + ".ppm";
+        if (!WritePPM(goldenPath, ImageFromPixels(context.GetPixels(), context.GetWidth(), context.GetHeight(), OffscreenContext::PIXEL_SIZE)))
+        {
+            std::print("Unable to write {}\n", goldenPath);
+            return EXIT_FAILURE;
+        }
+        std::print("Updated {}\n", goldenPath);
+    }
+
+    std::string baselinePath = options.goldenDirectory + "/" + scene.name + ".frame_ms";
+    double medianFrameTime = Median(frameTimes);
+    if (!WriteBaseline(baselinePath, medianFrameTime))
+    {
+        std::print("Unable to write {}\n", baselinePath);
+        return EXIT_FAILURE;
+    }
+    std::print("Updated {} with a median frame of {:.3f} ms\n", baselinePath, medianFrameTime);
+    return EXIT_SUCCESS;
+}
+
+static bool CheckImage(const OffscreenContext &context, const Scene &scene, const TestOptions &options)
+{
+    std::string goldenPath = options.goldenDirectory + "/" + scene.golden + ".ppm";
+    Image golden;
+    if (!ReadPPM(goldenPath, golden))
+    {
+        std::print("No golden image at {}, generate it on the reference device with the update_golden_images target\n", goldenPath);
+        return false;
+    }
+
+    // Compare straight out of the mapped readback buffer, images are only built to report a failure
+    const uint8_t *pixels = context.GetPixels();
+    CompareResult comparison = CompareImages(golden, pixels, context.GetWidth(), context.GetHeight(), OffscreenContext::PIXEL_SIZE, scene.threshold);
+    std::print("{}: {} pixels ({:.3f}%) differ from {}, {:.3f}% allowed\n",
+            scene.name, comparison.differingPixels, comparison.differingFraction * 100.0, goldenPath, scene.maxDifferingFraction * 100.0);
+    if (comparison.differingFraction <= scene.maxDifferingFraction)
+        return true;
+
+    std::filesystem::create_directories(options.outputDirectory);
+    std::string actualPath = options.outputDirectory + "/" + scene.name + "_actual.ppm";
+    WritePPM(actualPath, ImageFromPixels(pixels, context.GetWidth(), context.GetHeight(), OffscreenContext::PIXEL_SIZE));
+    if (golden.width == context.GetWidth() && golden.height == context.GetHeight())
+    {
+        std::string diffPath = options.outputDirectory + "/" + scene.name + "_diff.ppm";
+        WritePPM(diffPath, DiffImage(golden, pixels, OffscreenContext::PIXEL_SIZE, scene.threshold));
+        std::print("Image mismatch, wrote {} and {}\n", actualPath, diffPath);
+    }
+    else
+        std::print("Image size mismatch, golden is {}x{}, wrote {}\n", golden.width, golden.height, actualPath);
+    return false;
+}
+
+static bool CheckFrameBudget(const Scene &scene, const std::vector<double> &frameTimes, const TestOptions &options)
+{
+    std::string baselinePath = options.goldenDirectory + "/" + scene.name + ".frame_ms";
+    double medianFrameTime = Median(frameTimes);
+    double baseline = 0.0;
+    if (!ReadBaseline(baselinePath, baseline))
+    {
+        std::print("{}: median frame {:.3f} ms, but there is no baseline at {}, record it with the update_golden_images target\n",
+                scene.name, medianFrameTime, baselinePath);
+        return false;
+    }
+
+    double budget = baseline * BUDGET_MARGIN * GetBudgetScale();
+    std::print("{}: median frame {:.3f} ms, baseline {:.3f} ms, budget {:.3f} ms\n", scene.name, medianFrameTime, baseline, budget);
+    if (medianFrameTime > budget)
+    {
+        std::print("Frame budget exceeded\n");
+        return false;
+    }
+    return true;
+}
+
+// Renders the other scene, which overwrites the readback, so this has to run after the image check
+static bool CheckNotSlower(OffscreenContext &context, const Scene &scene, const SceneTimings &timings)
+{
+    const Scene &other = *FindScene(scene.notSlowerThan);
+    SceneTimings otherTimings = RenderScene(context, other);
+    if (timings.gpuTimes.empty() || otherTimings.gpuTimes.empty())
+    {
+        std::print("{}: no GPU timestamps, can't compare the draw against {}\n", scene.name, other.name);
+        return true;
+    }
+
+    double gpuTime = Median(timings.gpuTimes);
+    double otherGpuTime = Median(otherTimings.gpuTimes);
+    double ratio = gpuTime / otherGpuTime;
+    std::print("{}: median draw {:.3f} ms on the GPU against {:.3f} ms for {}, {:.2f}x\n",
+            scene.name, gpuTime, otherGpuTime, other.name, ratio);
+
+    if (context.GetPhysicalDevice().getProperties().deviceType == vk::PhysicalDeviceType::eCpu)
+        return true;
+    if (ratio > GPU_TIME_MARGIN)
+    {
+        std::print("{} draws slower than {}\n", scene.name, other.name);
+        return false;
+    }
+    return true;
+}
+
+static int RunTest(OffscreenContext &context, const Scene &scene, const TestOptions &options)
+{
+    SceneTimings timings = RenderScene(context, scene);
+    if (options.updateGolden)
+        return UpdateGolden(context, scene, timings.frameTimes, options);
+
+    // Run every check so one failure doesn't hide another
+    bool passed = CheckImage(context, scene, options);
+    passed = CheckFrameBudget(scene, timings.frameTimes, options) && passed;
+    if (scene.notSlowerThan)
+        passed = CheckNotSlower(context, scene, timings) && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char **argv)
+{
+    TestOptions options = TestOptions::FromArgs(argc, argv);
+
+    const Scene *scene = FindScene(options.scene);
+    if (!scene)
+    {
+        std::print("Unknown scene: {}\n", options.scene);
+        return EXIT_FAILURE;
+    }
+
+    OffscreenContext context;
+    int result = EXIT_FAILURE;
+    try
+    {
+        if (!context.Create(TARGET_WIDTH, TARGET_HEIGHT))
+        {
+            std::print("No Vulkan 1.3 device available, skipping\n");
+            context.Destroy();
+            return SKIP_RETURN_CODE;
+        }
+        result = RunTest(context, *scene, options);
+    }
+    catch (const std::exception &e)
+    {
+        std::print("{}\n", e.what());
+    }
+    context.Destroy();
+    return result;
+}